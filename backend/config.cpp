@@ -16,6 +16,16 @@ int get_env_int(const char* key, int defVal) {
 	}
 }
 
+// "dir/name.db" -> "dir/name<suffix>.db"
+std::string sibling_db_path(const std::string& dbPath, const char* suffix) {
+	const auto dot = dbPath.rfind('.');
+	const auto slash = dbPath.find_last_of("/\\");
+	if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) {
+		return dbPath + suffix;
+	}
+	return dbPath.substr(0, dot) + suffix + dbPath.substr(dot);
+}
+
 std::string get_server_host() {
 	return get_env_str("BACKEND_HOST", "127.0.0.1");
 }
@@ -24,4 +34,94 @@ int get_server_port() {
 	return get_env_int("BACKEND_PORT", 8081);
 }
 
+std::string get_storage_engine() {
+	return get_env_str("STORAGE_ENGINE", "sqlite");
+}
+
+int get_db_reader_pool_size() {
+	const int size = get_env_int("DB_READER_POOL_SIZE", 4);
+	return size < 0 ? 0 : size;
+}
+
+int get_compression_min_bytes() {
+	const int bytes = get_env_int("COMPRESSION_MIN_BYTES", 1024);
+	return bytes < 0 ? 0 : bytes;
+}
+
+int get_sse_max_subscribers() {
+	const int count = get_env_int("SSE_MAX_SUBSCRIBERS", 64);
+	return count < 0 ? 0 : count;
+}
+
+int get_sse_heartbeat_seconds() {
+	const int seconds = get_env_int("SSE_HEARTBEAT_SECONDS", 15);
+	return seconds < 1 ? 1 : seconds;
+}
+
+int get_order_group_commit_max_batch() {
+	return get_env_int("ORDER_GROUP_COMMIT_MAX_BATCH", 0);
+}
+
+int get_order_group_commit_max_wait_us() {
+	const int wait = get_env_int("ORDER_GROUP_COMMIT_MAX_WAIT_US", 500);
+	return wait < 0 ? 0 : wait;
+}
+
+std::string get_order_event_log_dir() {
+	return get_env_str("ORDER_EVENT_LOG_DIR", "");
+}
+
+int get_order_event_log_segment_mb() {
+	const int mb = get_env_int("ORDER_EVENT_LOG_SEGMENT_MB", 16);
+	return mb < 1 ? 1 : mb;
+}
 
+std::string get_archive_db_path(const std::string& dbPath) {
+	const char* v = std::getenv("ARCHIVE_DB_PATH");
+	return v ? std::string(v) : sibling_db_path(dbPath, "_archive");
+}
+
+int get_archive_after_days() {
+	const int days = get_env_int("ARCHIVE_AFTER_DAYS", 30);
+	return days < 0 ? 0 : days;
+}
+
+int get_archive_interval_minutes() {
+	const int minutes = get_env_int("ARCHIVE_INTERVAL_MINUTES", 60);
+	return minutes < 1 ? 1 : minutes;
+}
+
+int get_session_sweep_interval_seconds() {
+	const int seconds = get_env_int("SESSION_SWEEP_INTERVAL_SECONDS", 300);
+	return seconds < 1 ? 1 : seconds;
+}
+
+int get_session_sweep_batch_size() {
+	const int size = get_env_int("SESSION_SWEEP_BATCH_SIZE", 500);
+	return size < 1 ? 1 : size;
+}
+
+std::string get_backup_path(const std::string& dbPath) {
+	const char* v = std::getenv("BACKUP_PATH");
+	return v ? std::string(v) : sibling_db_path(dbPath, "_backup");
+}
+
+std::string get_archive_backup_path(const std::string& backupPath) {
+	const char* v = std::getenv("ARCHIVE_BACKUP_PATH");
+	return v ? std::string(v) : sibling_db_path(backupPath, "_archive");
+}
+
+int get_backup_interval_minutes() {
+	const int minutes = get_env_int("BACKUP_INTERVAL_MINUTES", 1440);
+	return minutes < 0 ? 0 : minutes;
+}
+
+int get_backup_pages_per_step() {
+	const int pages = get_env_int("BACKUP_PAGES_PER_STEP", 64);
+	return pages < 1 ? 1 : pages;
+}
+
+int get_backup_step_pause_ms() {
+	const int pause = get_env_int("BACKUP_STEP_PAUSE_MS", 5);
+	return pause < 0 ? 0 : pause;
+}
@@ -3,5 +3,34 @@
 
 std::string get_server_host();
 int get_server_port();
-
+// "sqlite" (default) or "memory"; the in-memory engine keeps nothing across restarts.
+std::string get_storage_engine();
+// Extra read-only SQLite connections (WAL mode); 0 keeps a single connection.
+int get_db_reader_pool_size();
+// Responses smaller than this many bytes are sent uncompressed.
+int get_compression_min_bytes();
+// Order event streams: how many may be open at once (each holds a thread, started on demand) and the heartbeat period.
+int get_sse_max_subscribers();
+int get_sse_heartbeat_seconds();
+// Group commit for order creation; a max batch of 0 or 1 commits each order on its own.
+int get_order_group_commit_max_batch();
+int get_order_group_commit_max_wait_us();
+// Directory of the order event log; empty keeps order writes going straight to SQLite.
+std::string get_order_event_log_dir();
+int get_order_event_log_segment_mb();
+// Archive database for old completed orders; defaults to "<db>_archive.db" next to the main file.
+std::string get_archive_db_path(const std::string& dbPath);
+// Days after completion before an order is archived; 0 disables archiving.
+int get_archive_after_days();
+int get_archive_interval_minutes();
+// Expired session cleanup: how often it runs and how many rows each delete removes.
+int get_session_sweep_interval_seconds();
+int get_session_sweep_batch_size();
+// Online backup of the main database; an interval of 0 leaves only the admin trigger.
+std::string get_backup_path(const std::string& dbPath);
+// Copy of the archive database, taken with each backup while it is attached.
+std::string get_archive_backup_path(const std::string& backupPath);
+int get_backup_interval_minutes();
+int get_backup_pages_per_step();
+int get_backup_step_pause_ms();
 
@@ -1,5 +1,11 @@
 #include "AdminController.h"
+#include "CompressedResponse.h"
+#include "PageParams.h"
+#include "../services/JsonValues.h"
+#include "../services/MenuTransfer.h"
 #include <nlohmann/json.hpp>
+#include <algorithm>
+#include <memory>
 #include <optional>
 
 using json = nlohmann::json;
@@ -39,8 +45,8 @@ namespace {
 			{"total", o.total},
 			{"items", items},
 			{"pickupNotified", o.pickupNotified},
-			{"createdAt", o.createdAt},
-			{"updatedAt", o.updatedAt}
+			{"createdAt", formatEpochMillis(o.createdAt)},
+			{"updatedAt", formatEpochMillis(o.updatedAt)}
 		};
 		if (o.userId.has_value()) {
 			result["userId"] = o.userId.value();
@@ -48,6 +54,96 @@ namespace {
 		return result;
 	}
 
+	json serializeBackupStatus(const BackupStatus& s) {
+		json result = {
+			{"running", s.running},
+			{"path", s.path},
+			{"pagesTotal", s.pagesTotal},
+			{"pagesRemaining", s.pagesRemaining},
+			{"lastSucceeded", s.lastSucceeded},
+			{"startedAt", nullptr},
+			{"finishedAt", nullptr}
+		};
+		if (s.startedAt > 0) result["startedAt"] = formatEpochMillis(s.startedAt);
+		if (s.finishedAt > 0) result["finishedAt"] = formatEpochMillis(s.finishedAt);
+		if (!s.lastError.empty()) result["lastError"] = s.lastError;
+		if (!s.archivePath.empty()) result["archivePath"] = s.archivePath;
+		return result;
+	}
+
+	bool isValidStatus(const std::string& status) {
+		return status == "pending" || status == "preparing" || status == "ready" || status == "completed";
+	}
+
+	constexpr int kStreamBatchSize = 200;
+	constexpr size_t kMaxBatchStatusUpdates = 500;
+
+	struct OrderStreamState {
+		std::optional<int> beforeId;
+		bool started{false};
+		bool includeArchived{false};
+	};
+
+	// Streams every order as one JSON array, fetching a keyset page per chunk so
+	// memory stays flat and no read snapshot is held while the client is slow.
+	void streamAllOrders(httplib::Response& res, OrderService& orderService, bool includeArchived) {
+		auto state = std::make_shared<OrderStreamState>();
+		state->includeArchived = includeArchived;
+		res.set_chunked_content_provider("application/json", [state, &orderService](size_t, httplib::DataSink& sink) {
+			std::string err;
+			auto page = orderService.getAllOrdersPage(state->beforeId, kStreamBatchSize, err, state->includeArchived);
+			if (!err.empty()) {
+				return false;
+			}
+			std::string chunk;
+			for (const auto& o : page.orders) {
+				chunk += state->started ? "," : "[";
+				state->started = true;
+				chunk += serializeOrderBrief(o).dump();
+			}
+			if (!page.nextBeforeId.has_value()) {
+				chunk += state->started ? "]" : "[]";
+				sink.write(chunk.data(), chunk.size());
+				sink.done();
+				return true;
+			}
+			state->beforeId = page.nextBeforeId;
+			return sink.write(chunk.data(), chunk.size());
+		});
+	}
+
+	struct MenuExportState {
+		int afterId{0};
+		bool headerSent{false};
+	};
+
+	// Streams the menu a keyset page at a time, like streamAllOrders.
+	void streamMenu(httplib::Response& res, MenuService& menuService, MenuFormat format) {
+		auto state = std::make_shared<MenuExportState>();
+		res.set_chunked_content_provider(menuFormatContentType(format), [state, format, &menuService](size_t, httplib::DataSink& sink) {
+			std::string err;
+			auto dishes = menuService.getMenuPage(state->afterId, kStreamBatchSize, err);
+			if (!err.empty()) {
+				return false;
+			}
+			std::string chunk;
+			if (!state->headerSent) {
+				chunk = menuExportHeader(format);
+				state->headerSent = true;
+			}
+			for (const auto& d : dishes) {
+				chunk += formatMenuRow(d, format);
+			}
+			if (dishes.size() < static_cast<size_t>(kStreamBatchSize)) {
+				sink.write(chunk.data(), chunk.size());
+				sink.done();
+				return true;
+			}
+			state->afterId = dishes.back().id;
+			return sink.write(chunk.data(), chunk.size());
+		});
+	}
+
 	json serializeDish(const Dish& d) {
 		return json{
 			{"id", d.id},
@@ -60,21 +156,129 @@ namespace {
 	}
 }
 
-void registerAdminRoutes(httplib::Server& server, OrderService& orderService, MenuService& menuService, AuthService& authService) {
+void registerAdminRoutes(httplib::Server& server, OrderService& orderService, MenuService& menuService, AuthService& authService, BackupService& backupService) {
 	server.Get("/admin/orders", [&](const httplib::Request& req, httplib::Response& res) {
 		if (!requireMerchant(req, res, authService).has_value()) return;
+		std::optional<PageParams> page;
+		try {
+			page = parsePageParams(req);
+		} catch (const std::exception&) {
+			res.status = 400;
+			res.set_content(R"({"error":"limit and before_id must be integers"})", "application/json");
+			return;
+		}
+		if (!page.has_value()) {
+			streamAllOrders(res, orderService, wantsArchived(req));
+			return;
+		}
 		std::string err;
-		auto orders = orderService.getAllOrders(err);
+		auto result = orderService.getAllOrdersPage(page->beforeId, page->limit, err, wantsArchived(req));
 		if (!err.empty()) {
 			res.status = 500;
 			res.set_content(json({{"error", err}}).dump(), "application/json");
 			return;
 		}
 		json arr = json::array();
-		for (const auto& o : orders) {
+		for (const auto& o : result.orders) {
 			arr.push_back(serializeOrderBrief(o));
 		}
-		res.set_content(arr.dump(), "application/json");
+		json body{{"orders", arr}, {"nextBeforeId", nullptr}};
+		if (result.nextBeforeId.has_value()) {
+			body["nextBeforeId"] = result.nextBeforeId.value();
+		}
+		setCompressedContent(req, res, body.dump(), "application/json");
+	});
+
+	server.Get("/admin/orders/active", [&](const httplib::Request& req, httplib::Response& res) {
+		if (!requireMerchant(req, res, authService).has_value()) return;
+		std::optional<std::string> status;
+		if (req.has_param("status")) {
+			status = req.get_param_value("status");
+		}
+		json arr = json::array();
+		for (const auto& o : orderService.getActiveOrders(status)) {
+			arr.push_back(serializeOrderBrief(o));
+		}
+		setCompressedContent(req, res, arr.dump(), "application/json");
+	});
+
+	// Body: {"updates": [{"id": 1, "status": "ready"}, ...]}. Valid entries are
+	// applied together; the response has one result per entry, in order.
+	server.Patch("/admin/orders/status", [&](const httplib::Request& req, httplib::Response& res) {
+		if (!requireMerchant(req, res, authService).has_value()) return;
+		json body;
+		try {
+			body = json::parse(req.body);
+		} catch (const std::exception& e) {
+			res.status = 400;
+			res.set_content(json({{"error", std::string("invalid json: ") + e.what()}}).dump(), "application/json");
+			return;
+		}
+		if (!body.is_object() || !body.contains("updates") || !body["updates"].is_array()) {
+			res.status = 400;
+			res.set_content(R"({"error":"updates array required"})", "application/json");
+			return;
+		}
+		const auto& entries = body["updates"];
+		if (entries.empty() || entries.size() > kMaxBatchStatusUpdates) {
+			res.status = 400;
+			res.set_content(json({{"error", "updates must hold 1 to " + std::to_string(kMaxBatchStatusUpdates) + " entries"}}).dump(), "application/json");
+			return;
+		}
+
+		json results = json::array();
+		std::vector<OrderStatusUpdate> updates;
+		// Index into results for each entry of updates.
+		std::vector<size_t> slots;
+		for (const auto& entry : entries) {
+			json result = {{"id", nullptr}, {"ok", false}};
+			const auto id = entry.is_object() && entry.contains("id") ? jsonIntValue(entry["id"]) : std::nullopt;
+			if (id.has_value()) {
+				result["id"] = id.value();
+			}
+			if (!id.has_value()) {
+				result["error"] = "id must be an integer";
+			} else if (!entry.contains("status") || !entry["status"].is_string()) {
+				result["error"] = "status field required";
+			} else if (!isValidStatus(entry["status"].get<std::string>())) {
+				result["error"] = "invalid status";
+			} else {
+				updates.push_back({id.value(), entry["status"].get<std::string>()});
+				slots.push_back(results.size());
+			}
+			results.push_back(result);
+		}
+
+		if (!updates.empty()) {
+			std::string err;
+			auto orders = orderService.updateOrderStatuses(updates, err);
+			if (!orders.has_value()) {
+				res.status = 500;
+				res.set_content(json({{"error", err}}).dump(), "application/json");
+				return;
+			}
+			for (size_t i = 0; i < updates.size(); ++i) {
+				json& result = results[slots[i]];
+				const auto& order = orders.value()[i];
+				if (order.has_value() && order->archived) {
+					result["error"] = "order is archived";
+				} else if (order.has_value()) {
+					result["ok"] = true;
+					result["order"] = serializeOrderBrief(order.value());
+				} else {
+					result["error"] = "order not found";
+				}
+			}
+		}
+		int updated = 0;
+		for (const auto& result : results) {
+			updated += result["ok"].get<bool>() ? 1 : 0;
+		}
+		res.set_content(json({
+			{"updated", updated},
+			{"failed", static_cast<int>(results.size()) - updated},
+			{"results", results}
+		}).dump(), "application/json");
 	});
 
 	server.Patch(R"(/admin/orders/(\d+)/status)", [&](const httplib::Request& req, httplib::Response& res) {
@@ -88,7 +292,7 @@ void registerAdminRoutes(httplib::Server& server, OrderService& orderService, Me
 				return;
 			}
 			const std::string status = body["status"].get<std::string>();
-			if (status != "pending" && status != "preparing" && status != "ready" && status != "completed") {
+			if (!isValidStatus(status)) {
 				res.status = 400;
 				res.set_content(R"({"error":"invalid status"})", "application/json");
 				return;
@@ -105,6 +309,11 @@ void registerAdminRoutes(httplib::Server& server, OrderService& orderService, Me
 				res.set_content(R"({"error":"order not found"})", "application/json");
 				return;
 			}
+			if (order->archived) {
+				res.status = 409;
+				res.set_content(R"({"error":"order is archived"})", "application/json");
+				return;
+			}
 			res.set_content(serializeOrderBrief(order.value()).dump(), "application/json");
 		} catch (const std::exception& e) {
 			res.status = 400;
@@ -112,6 +321,83 @@ void registerAdminRoutes(httplib::Server& server, OrderService& orderService, Me
 		}
 	});
 
+	server.Get("/admin/stats", [&](const httplib::Request& req, httplib::Response& res) {
+		if (!requireMerchant(req, res, authService).has_value()) return;
+		// ?from=&to= are inclusive YYYY-MM-DD (UTC); default is the last 30 days.
+		const EpochDay today = epochDayOf(nowEpochMillis());
+		std::optional<EpochDay> to = today;
+		if (req.has_param("to")) {
+			to = parseEpochDay(req.get_param_value("to"));
+		}
+		std::optional<EpochDay> from = to ? std::optional<EpochDay>(*to - 29) : std::nullopt;
+		if (req.has_param("from")) {
+			from = parseEpochDay(req.get_param_value("from"));
+		}
+		if (!from.has_value() || !to.has_value() || *from > *to) {
+			res.status = 400;
+			res.set_content(R"({"error":"from and to must be YYYY-MM-DD dates with from <= to"})", "application/json");
+			return;
+		}
+		std::string err;
+		const auto report = orderService.getSalesReport(*from, *to, err);
+		if (!err.empty()) {
+			res.status = 500;
+			res.set_content(json({{"error", err}}).dump(), "application/json");
+			return;
+		}
+		int orderCount = 0;
+		double revenue = 0.0;
+		int completedCount = 0;
+		double completedRevenue = 0.0;
+		json days = json::array();
+		for (const auto& d : report.days) {
+			orderCount += d.orderCount;
+			revenue += d.revenue;
+			completedCount += d.completedCount;
+			completedRevenue += d.completedRevenue;
+			days.push_back({
+				{"date", formatEpochDay(d.day)},
+				{"orders", d.orderCount},
+				{"revenue", d.revenue},
+				{"completedOrders", d.completedCount},
+				{"completedRevenue", d.completedRevenue}
+			});
+		}
+		json dishes = json::array();
+		for (const auto& d : report.dishes) {
+			dishes.push_back({{"dishId", d.dishId}, {"name", d.name}, {"quantity", d.quantity}, {"revenue", d.revenue}});
+		}
+		json body = {
+			{"from", formatEpochDay(*from)},
+			{"to", formatEpochDay(*to)},
+			{"totals", {
+				{"orders", orderCount},
+				{"revenue", revenue},
+				{"completedOrders", completedCount},
+				{"completedRevenue", completedRevenue}
+			}},
+			{"days", days},
+			{"dishes", dishes}
+		};
+		res.set_content(body.dump(), "application/json");
+	});
+
+	server.Post("/admin/backup", [&](const httplib::Request& req, httplib::Response& res) {
+		if (!requireMerchant(req, res, authService).has_value()) return;
+		if (!backupService.trigger()) {
+			res.status = 409;
+			res.set_content(json({{"error", "backup already running"}, {"backup", serializeBackupStatus(backupService.status())}}).dump(), "application/json");
+			return;
+		}
+		res.status = 202;
+		res.set_content(serializeBackupStatus(backupService.status()).dump(), "application/json");
+	});
+
+	server.Get("/admin/backup", [&](const httplib::Request& req, httplib::Response& res) {
+		if (!requireMerchant(req, res, authService).has_value()) return;
+		res.set_content(serializeBackupStatus(backupService.status()).dump(), "application/json");
+	});
+
 	server.Get("/admin/menu", [&](const httplib::Request& req, httplib::Response& res) {
 		if (!requireMerchant(req, res, authService).has_value()) return;
 		std::string err;
@@ -125,7 +411,7 @@ void registerAdminRoutes(httplib::Server& server, OrderService& orderService, Me
 		for (const auto& d : dishes) {
 			arr.push_back(serializeDish(d));
 		}
-		res.set_content(arr.dump(), "application/json");
+		setCompressedContent(req, res, arr.dump(), "application/json");
 	});
 
 	server.Post("/admin/menu", [&](const httplib::Request& req, httplib::Response& res) {
@@ -164,6 +450,56 @@ void registerAdminRoutes(httplib::Server& server, OrderService& orderService, Me
 		}
 	});
 
+	// Body is NDJSON or CSV (see MenuTransfer.h), chosen by ?format= or the
+	// Content-Type. Rows are parsed as the body arrives and written in a single
+	// transaction once it is complete; one bad row rejects the whole import.
+	server.Post("/admin/menu/import", [&](const httplib::Request& req, httplib::Response& res, const httplib::ContentReader& contentReader) {
+		if (!requireMerchant(req, res, authService).has_value()) return;
+		const auto format = parseMenuFormat(req.has_param("format") ? req.get_param_value("format") : req.get_header_value("Content-Type"));
+		if (!format.has_value()) {
+			res.status = 415;
+			res.set_content(R"({"error":"send text/csv or application/x-ndjson, or pass ?format=csv|ndjson"})", "application/json");
+			return;
+		}
+		MenuImportParser parser(format.value());
+		std::string err;
+		const bool received = contentReader([&](const char* data, size_t size) {
+			return parser.feed(data, size, err);
+		});
+		if (!received || !parser.finish(err)) {
+			res.status = 400;
+			res.set_content(json({{"error", err.empty() ? "failed to read request body" : err}}).dump(), "application/json");
+			return;
+		}
+		if (parser.rows().empty()) {
+			res.status = 400;
+			res.set_content(R"({"error":"no dishes to import"})", "application/json");
+			return;
+		}
+		auto imported = menuService.importDishes(parser.rows(), err);
+		if (!imported.has_value()) {
+			res.status = 500;
+			res.set_content(json({{"error", err}}).dump(), "application/json");
+			return;
+		}
+		res.set_content(json({{"imported", imported.value()}}).dump(), "application/json");
+	});
+
+	server.Get("/admin/menu/export", [&](const httplib::Request& req, httplib::Response& res) {
+		if (!requireMerchant(req, res, authService).has_value()) return;
+		auto format = std::optional<MenuFormat>(MenuFormat::Ndjson);
+		if (req.has_param("format")) {
+			format = parseMenuFormat(req.get_param_value("format"));
+		}
+		if (!format.has_value()) {
+			res.status = 400;
+			res.set_content(R"({"error":"format must be csv or ndjson"})", "application/json");
+			return;
+		}
+		res.set_header("Content-Disposition", format == MenuFormat::Csv ? "attachment; filename=\"menu.csv\"" : "attachment; filename=\"menu.ndjson\"");
+		streamMenu(res, menuService, format.value());
+	});
+
 	server.Patch(R"(/admin/menu/(\d+))", [&](const httplib::Request& req, httplib::Response& res) {
 		if (!requireMerchant(req, res, authService).has_value()) return;
 		try {
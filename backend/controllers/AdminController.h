@@ -5,8 +5,9 @@
 #include "../services/OrderService.h"
 #include "../services/MenuService.h"
 #include "../services/AuthService.h"
+#include "../services/BackupService.h"
 
-void registerAdminRoutes(httplib::Server& server, OrderService& orderService, MenuService& menuService, AuthService& authService);
+void registerAdminRoutes(httplib::Server& server, OrderService& orderService, MenuService& menuService, AuthService& authService, BackupService& backupService);
 
 #endif // ADMIN_CONTROLLER_H
 
@@ -0,0 +1,23 @@
+#include "CompressedResponse.h"
+
+void setEncodedContent(httplib::Response& res, const std::string& body, ContentEncoding encoding, const char* contentType) {
+	res.set_header("Vary", "Accept-Encoding");
+	if (encoding != ContentEncoding::Identity) {
+		res.set_header("Content-Encoding", contentEncodingName(encoding));
+	}
+	res.set_content(body, contentType);
+}
+
+void setCompressedContent(const httplib::Request& req, httplib::Response& res, const std::string& body, const char* contentType) {
+	const ContentEncoding encoding = body.size() < compressionMinBytes()
+		? ContentEncoding::Identity
+		: negotiateEncoding(req.get_header_value("Accept-Encoding"));
+	if (encoding != ContentEncoding::Identity) {
+		auto compressed = compressBody(body, encoding, CompressionEffort::Fast);
+		if (compressed && compressed->size() < body.size()) {
+			setEncodedContent(res, compressed.value(), encoding, contentType);
+			return;
+		}
+	}
+	setEncodedContent(res, body, ContentEncoding::Identity, contentType);
+}
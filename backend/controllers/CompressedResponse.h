@@ -0,0 +1,15 @@
+#ifndef COMPRESSED_RESPONSE_H
+#define COMPRESSED_RESPONSE_H
+
+#include <httplib.h>
+#include <string>
+#include "../services/ResponseCompression.h"
+
+// Sends body already encoded with encoding, marking the response as varying
+// by Accept-Encoding.
+void setEncodedContent(httplib::Response& res, const std::string& body, ContentEncoding encoding, const char* contentType);
+// Compresses body for this request when it reaches compressionMinBytes() and
+// the client accepts a supported coding; otherwise sends it as is.
+void setCompressedContent(const httplib::Request& req, httplib::Response& res, const std::string& body, const char* contentType);
+
+#endif // COMPRESSED_RESPONSE_H
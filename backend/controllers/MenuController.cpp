@@ -1,20 +1,80 @@
 #include "MenuController.h"
+#include "CompressedResponse.h"
 #include <nlohmann/json.hpp>
 
 using json = nlohmann::json;
 
+namespace {
+	// True if the If-None-Match list names etag (weak comparison, so a W/
+	// prefix added by a proxy still matches) or is "*".
+	bool etagMatches(const std::string& ifNoneMatch, const std::string& etag) {
+		size_t pos = 0;
+		while (pos < ifNoneMatch.size()) {
+			size_t end = ifNoneMatch.find(',', pos);
+			if (end == std::string::npos) end = ifNoneMatch.size();
+			std::string tag = ifNoneMatch.substr(pos, end - pos);
+			const size_t first = tag.find_first_not_of(" \t");
+			const size_t last = tag.find_last_not_of(" \t");
+			tag = first == std::string::npos ? "" : tag.substr(first, last - first + 1);
+			if (tag.compare(0, 2, "W/") == 0) tag.erase(0, 2);
+			if (tag == "*" || tag == etag) return true;
+			pos = end + 1;
+		}
+		return false;
+	}
+
+	// Each coding is its own representation and needs its own strong ETag.
+	std::string representationEtag(const std::string& etag, ContentEncoding encoding) {
+		if (encoding == ContentEncoding::Identity) return etag;
+		return etag.substr(0, etag.size() - 1) + "-" + contentEncodingName(encoding) + "\"";
+	}
+}
+
 void registerMenuRoutes(httplib::Server& server, MenuService& menuService) {
-	server.Get("/menu", [&](const httplib::Request&, httplib::Response& res) {
+	// The body is serialized and compressed once per menu change; clients
+	// revalidate with If-None-Match and get 304 while it is unchanged.
+	server.Get("/menu", [&](const httplib::Request& req, httplib::Response& res) {
 		std::string err;
-		auto menu = menuService.getMenu(err);
-		if (!err.empty()) {
+		auto menu = menuService.getMenuSnapshot(err);
+		if (!menu) {
+			res.status = 500;
+			res.set_content(json({{"error", err}}).dump(), "application/json");
+			return;
+		}
+		ContentEncoding encoding;
+		const std::string& body = menu->body.select(req.get_header_value("Accept-Encoding"), encoding);
+		const std::string etag = representationEtag(menu->etag, encoding);
+		res.set_header("ETag", etag);
+		res.set_header("Cache-Control", "no-cache");
+		if (etagMatches(req.get_header_value("If-None-Match"), etag)) {
+			res.set_header("Vary", "Accept-Encoding");
+			res.status = 304;
+			return;
+		}
+		setEncodedContent(res, body, encoding, "application/json");
+	});
+	// Substring search over name, description and category of available
+	// dishes; several terms separated by spaces must all match.
+	server.Get("/menu/search", [&](const httplib::Request& req, httplib::Response& res) {
+		const std::string query = req.get_param_value("q");
+		std::optional<std::string> category;
+		if (req.has_param("category")) {
+			category = req.get_param_value("category");
+		}
+		if (query.empty() && !category.has_value()) {
+			res.status = 400;
+			res.set_content(R"({"error":"q or category required"})", "application/json");
+			return;
+		}
+		std::string err;
+		auto dishes = menuService.searchMenu(query, category, err);
+		if (!dishes.has_value()) {
 			res.status = 500;
 			res.set_content(json({{"error", err}}).dump(), "application/json");
 			return;
 		}
 		json arr = json::array();
-		for (const auto& d : menu) {
-			if (!d.isAvailable) continue;
+		for (const auto& d : dishes.value()) {
 			arr.push_back({
 				{"id", d.id},
 				{"name", d.name},
@@ -23,8 +83,6 @@ void registerMenuRoutes(httplib::Server& server, MenuService& menuService) {
 				{"price", d.price}
 			});
 		}
-		res.set_content(arr.dump(), "application/json");
+		setCompressedContent(req, res, arr.dump(), "application/json");
 	});
 }
-
-
@@ -1,5 +1,13 @@
 #include "OrderController.h"
+#include "CompressedResponse.h"
+#include "PageParams.h"
+#include "WorkerPool.h"
 #include <nlohmann/json.hpp>
+#include <algorithm>
+#include <charconv>
+#include <functional>
+#include <memory>
+#include <unordered_map>
 #include "../models/Order.h"
 
 using json = nlohmann::json;
@@ -68,17 +76,170 @@ namespace {
 			{"total", o.total},
 			{"items", items},
 			{"pickupNotified", o.pickupNotified},
-			{"createdAt", o.createdAt},
-			{"updatedAt", o.updatedAt}
+			{"createdAt", formatEpochMillis(o.createdAt)},
+			{"updatedAt", formatEpochMillis(o.updatedAt)}
 		};
 		if (o.userId.has_value()) {
 			obj["userId"] = o.userId.value();
 		}
 		return obj;
 	}
+
+	// The order if the caller may see it: its owner or any merchant.
+	// Otherwise sends the error response and returns nullopt.
+	std::optional<Order> requireVisibleOrder(const httplib::Request& req, httplib::Response& res, OrderService& orderService, AuthService& authService, int id) {
+		std::string err;
+		auto ord = orderService.getOrder(id, err);
+		if (!err.empty()) {
+			res.status = 500;
+			res.set_content(json({{"error", err}}).dump(), "application/json");
+			return std::nullopt;
+		}
+		if (!ord.has_value()) {
+			res.status = 404;
+			res.set_content(R"({"error":"order not found"})", "application/json");
+			return std::nullopt;
+		}
+
+		const auto token = extractToken(req);
+		if (!token.has_value()) {
+			res.status = 401;
+			res.set_content(R"({"error":"missing bearer token"})", "application/json");
+			return std::nullopt;
+		}
+		auto user = authService.authenticateUser(token.value(), err);
+		if (!user.has_value()) {
+			err.clear();
+			auto merchant = authService.authenticateMerchant(token.value(), err);
+			if (!merchant.has_value()) {
+				res.status = 401;
+				res.set_content(json({{"error", err.empty() ? "invalid token" : err}}).dump(), "application/json");
+				return std::nullopt;
+			}
+		} else {
+			if (ord->userId.has_value() && ord->userId.value() != user->id) {
+				res.status = 403;
+				res.set_content(R"({"error":"order does not belong to you"})", "application/json");
+				return std::nullopt;
+			}
+		}
+		return ord;
+	}
+
+	std::string formatOrderEvent(uint64_t eventId, const Order& order) {
+		auto data = serializeOrder(order);
+		data["pickupReady"] = order.status == "completed" && !order.pickupNotified;
+		return "id: " + std::to_string(eventId) + "\nevent: order\ndata: " + data.dump() + "\n\n";
+	}
+
+	// nullopt unless the header is a whole decimal that fits, so a bogus or
+	// overflowing id just replays the current state.
+	std::optional<uint64_t> parseLastEventId(const httplib::Request& req) {
+		const std::string value = req.get_header_value("Last-Event-ID");
+		const char* end = value.data() + value.size();
+		uint64_t id = 0;
+		const auto parsed = std::from_chars(value.data(), end, id);
+		if (value.empty() || parsed.ec != std::errc() || parsed.ptr != end) {
+			return std::nullopt;
+		}
+		return id;
+	}
+
+	struct OrderStream {
+		std::shared_ptr<OrderSubscription> subscription;
+		// Written before the first wait: the reconnect delay and, unless the
+		// client resumed, the current state.
+		std::string preamble;
+		// updatedAt of the state sent per order, so events queued before it
+		// was read do not roll the client back.
+		std::unordered_map<int, EpochMillis> sentAt;
+	};
+
+	// Gives back what a stream has acquired unless it was handed to the
+	// response's releaser, so an early return or an exception (say from
+	// currentState()) cannot leak a pool slot or a subscription.
+	struct StreamGuard {
+		OrderEventHub& hub;
+		WorkerPool* pool;
+		std::shared_ptr<OrderSubscription> subscription;
+		bool handedOff;
+
+		~StreamGuard() {
+			if (handedOff) return;
+			if (subscription) hub.unsubscribe(subscription);
+			if (pool) pool->leaveStream();
+		}
+	};
+
+	void refuseStream(httplib::Response& res) {
+		res.status = 503;
+		res.set_header("Retry-After", "30");
+		res.set_content(R"({"error":"too many open event streams"})", "application/json");
+	}
+
+	// Subscribes before reading the current state, so a change committed in
+	// between is delivered rather than lost. Each open stream holds its
+	// thread, asleep between events and heartbeats; the WorkerPool stands in
+	// another worker so ordinary requests keep theirs.
+	void streamOrderEvents(const httplib::Request& req, httplib::Response& res, OrderEventHub& hub,
+		const std::optional<int>& orderId, const std::optional<int>& userId,
+		const std::function<std::vector<Order>()>& currentState) {
+		const auto lastEventId = parseLastEventId(req);
+		WorkerPool* pool = WorkerPool::current();
+		if (pool && !pool->enterStream()) {
+			refuseStream(res);
+			return;
+		}
+		StreamGuard guard{hub, pool, nullptr, false};
+		bool resumed = false;
+		guard.subscription = hub.subscribe(orderId, userId, lastEventId, resumed);
+		if (!guard.subscription) {
+			refuseStream(res);
+			return;
+		}
+		auto stream = std::make_shared<OrderStream>();
+		stream->subscription = guard.subscription;
+		stream->preamble = "retry: 3000\n\n";
+		if (!resumed) {
+			const uint64_t eventId = hub.lastEventId();
+			for (const auto& order : currentState()) {
+				stream->preamble += formatOrderEvent(eventId, order);
+				stream->sentAt[order.id] = order.updatedAt;
+			}
+		}
+
+		res.set_header("Cache-Control", "no-cache");
+		res.set_header("X-Accel-Buffering", "no");
+		const auto heartbeat = std::chrono::duration_cast<std::chrono::milliseconds>(hub.heartbeatInterval());
+		res.set_chunked_content_provider("text/event-stream", [stream, heartbeat](size_t, httplib::DataSink& sink) {
+			std::string out;
+			out.swap(stream->preamble);
+			if (out.empty()) {
+				for (const auto& event : stream->subscription->wait(heartbeat)) {
+					const auto sent = stream->sentAt.find(event.order.id);
+					if (sent != stream->sentAt.end() && event.order.updatedAt < sent->second) continue;
+					out += formatOrderEvent(event.id, event.order);
+				}
+				if (stream->subscription->closed()) {
+					// Fell too far behind; the client reconnects and resumes.
+					sink.done();
+					return true;
+				}
+				if (out.empty()) {
+					out = ": ping\n\n";
+				}
+			}
+			return sink.write(out.data(), out.size());
+		}, [&hub, stream, pool](bool) {
+			hub.unsubscribe(stream->subscription);
+			if (pool) pool->leaveStream();
+		});
+		// The response now owns the releaser and runs it however it ends.
+		guard.handedOff = true;
+	}
 }
 
-void registerOrderRoutes(httplib::Server& server, OrderService& orderService, AuthService& authService) {
+void registerOrderRoutes(httplib::Server& server, OrderService& orderService, AuthService& authService, OrderEventHub& orderEvents) {
 	server.Post("/orders", [&](const httplib::Request& req, httplib::Response& res) {
 		try {
 			auto user = requireUser(req, res, authService);
@@ -115,65 +276,86 @@ void registerOrderRoutes(httplib::Server& server, OrderService& orderService, Au
 	server.Get("/me/orders", [&](const httplib::Request& req, httplib::Response& res) {
 		auto user = requireUser(req, res, authService);
 		if (!user.has_value()) return;
+		std::optional<PageParams> page;
+		try {
+			page = parsePageParams(req);
+		} catch (const std::exception&) {
+			res.status = 400;
+			res.set_content(R"({"error":"limit and before_id must be integers"})", "application/json");
+			return;
+		}
 		std::string err;
-		auto orders = orderService.getOrdersByUser(user->id, err);
+		OrderPage result;
+		if (page.has_value()) {
+			result = orderService.getOrdersByUserPage(user->id, page->beforeId, page->limit, err, wantsArchived(req));
+		} else {
+			result.orders = orderService.getOrdersByUser(user->id, err, wantsArchived(req));
+		}
 		if (!err.empty()) {
 			res.status = 500;
 			res.set_content(json({{"error", err}}).dump(), "application/json");
 			return;
 		}
 		json arr = json::array();
-		for (const auto& o : orders) {
+		for (const auto& o : result.orders) {
 			auto data = serializeOrder(o);
 			const bool pickupReady = o.status == "completed" && !o.pickupNotified;
 			data["pickupReady"] = pickupReady;
 			arr.push_back(data);
 		}
-		res.set_content(arr.dump(), "application/json");
-	});
-
-	server.Get(R"(/orders/(\d+))", [&](const httplib::Request& req, httplib::Response& res) {
-		int id = std::stoi(req.matches[1]);
-		std::string err;
-		auto ord = orderService.getOrder(id, err);
-		if (!err.empty()) {
-			res.status = 500;
-			res.set_content(json({{"error", err}}).dump(), "application/json");
+		if (!page.has_value()) {
+			setCompressedContent(req, res, arr.dump(), "application/json");
 			return;
 		}
-		if (!ord.has_value()) {
-			res.status = 404;
-			res.set_content(R"({"error":"order not found"})", "application/json");
-			return;
+		json body{{"orders", arr}, {"nextBeforeId", nullptr}};
+		if (result.nextBeforeId.has_value()) {
+			body["nextBeforeId"] = result.nextBeforeId.value();
 		}
+		setCompressedContent(req, res, body.dump(), "application/json");
+	});
 
-		const auto token = extractToken(req);
-		if (!token.has_value()) {
-			res.status = 401;
-			res.set_content(R"({"error":"missing bearer token"})", "application/json");
-			return;
-		}
-		auto user = authService.authenticateUser(token.value(), err);
-		if (!user.has_value()) {
-			err.clear();
-			auto merchant = authService.authenticateMerchant(token.value(), err);
-			if (!merchant.has_value()) {
-				res.status = 401;
-				res.set_content(json({{"error", err.empty() ? "invalid token" : err}}).dump(), "application/json");
-				return;
-			}
-		} else {
-			if (ord->userId.has_value() && ord->userId.value() != user->id) {
-				res.status = 403;
-				res.set_content(R"({"error":"order does not belong to you"})", "application/json");
-				return;
-			}
+	server.Get("/me/orders/active", [&](const httplib::Request& req, httplib::Response& res) {
+		auto user = requireUser(req, res, authService);
+		if (!user.has_value()) return;
+		json arr = json::array();
+		for (const auto& o : orderService.getActiveOrdersByUser(user->id)) {
+			auto data = serializeOrder(o);
+			data["pickupReady"] = o.status == "completed" && !o.pickupNotified;
+			arr.push_back(data);
 		}
+		setCompressedContent(req, res, arr.dump(), "application/json");
+	});
 
+	server.Get(R"(/orders/(\d+))", [&](const httplib::Request& req, httplib::Response& res) {
+		auto ord = requireVisibleOrder(req, res, orderService, authService, std::stoi(req.matches[1]));
+		if (!ord.has_value()) return;
 		auto payload = serializeOrder(ord.value());
 		res.set_content(payload.dump(), "application/json");
 	});
 
+	// Server-sent events: one "order" event with the serialized order (plus
+	// pickupReady) each time it changes, ": ping" comments in between.
+	server.Get(R"(/orders/(\d+)/events)", [&](const httplib::Request& req, httplib::Response& res) {
+		const int id = std::stoi(req.matches[1]);
+		if (!requireVisibleOrder(req, res, orderService, authService, id).has_value()) return;
+		streamOrderEvents(req, res, orderEvents, id, std::nullopt, [&orderService, id]() {
+			std::string err;
+			auto ord = orderService.getOrder(id, err);
+			return ord.has_value() ? std::vector<Order>{ord.value()} : std::vector<Order>();
+		});
+	});
+
+	// Like /orders/{id}/events for every order of the caller; the initial
+	// state is the caller's active orders.
+	server.Get("/me/orders/events", [&](const httplib::Request& req, httplib::Response& res) {
+		auto user = requireUser(req, res, authService);
+		if (!user.has_value()) return;
+		const int userId = user->id;
+		streamOrderEvents(req, res, orderEvents, std::nullopt, userId, [&orderService, userId]() {
+			return orderService.getActiveOrdersByUser(userId);
+		});
+	});
+
 	server.Post(R"(/orders/(\d+)/pickup-ack)", [&](const httplib::Request& req, httplib::Response& res) {
 		auto user = requireUser(req, res, authService);
 		if (!user.has_value()) return;
@@ -195,6 +377,11 @@ void registerOrderRoutes(httplib::Server& server, OrderService& orderService, Au
 			res.set_content(R"({"error":"order does not belong to you"})", "application/json");
 			return;
 		}
+		if (ord->archived) {
+			res.status = 409;
+			res.set_content(R"({"error":"order is archived"})", "application/json");
+			return;
+		}
 		if (!orderService.markPickupNotified(id, err)) {
 			res.status = 500;
 			res.set_content(json({{"error", err}}).dump(), "application/json");
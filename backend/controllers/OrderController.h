@@ -4,8 +4,9 @@
 #include <httplib.h>
 #include "../services/OrderService.h"
 #include "../services/AuthService.h"
+#include "../services/OrderEventHub.h"
 
-void registerOrderRoutes(httplib::Server& server, OrderService& orderService, AuthService& authService);
+void registerOrderRoutes(httplib::Server& server, OrderService& orderService, AuthService& authService, OrderEventHub& orderEvents);
 
 #endif // ORDER_CONTROLLER_H
 
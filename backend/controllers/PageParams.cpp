@@ -0,0 +1,33 @@
+#include "PageParams.h"
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include "../services/OrderService.h"
+
+namespace {
+	// std::stoi stops at the first non-digit; "10abc" must not read as 10.
+	int parseIntParam(const std::string& value) {
+		size_t used = 0;
+		const int result = std::stoi(value, &used);
+		if (used != value.size()) {
+			throw std::invalid_argument(value);
+		}
+		return result;
+	}
+}
+
+std::optional<PageParams> parsePageParams(const httplib::Request& req) {
+	if (!req.has_param("limit") && !req.has_param("before_id")) return std::nullopt;
+	PageParams page{std::nullopt, OrderService::kDefaultPageSize};
+	if (req.has_param("limit")) {
+		page.limit = std::clamp(parseIntParam(req.get_param_value("limit")), 1, OrderService::kMaxPageSize);
+	}
+	if (req.has_param("before_id")) {
+		page.beforeId = parseIntParam(req.get_param_value("before_id"));
+	}
+	return page;
+}
+
+bool wantsArchived(const httplib::Request& req) {
+	return req.has_param("includeArchived") && req.get_param_value("includeArchived") == "true";
+}
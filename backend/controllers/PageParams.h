@@ -0,0 +1,21 @@
+#ifndef PAGE_PARAMS_H
+#define PAGE_PARAMS_H
+
+#include <httplib.h>
+#include <optional>
+
+struct PageParams {
+	std::optional<int> beforeId;
+	int limit;
+};
+
+// Keyset pagination via ?limit=&before_id=. Returns nullopt when neither is
+// given so existing clients keep receiving the full array. Throws
+// std::invalid_argument or std::out_of_range unless each value is a whole
+// integer.
+std::optional<PageParams> parsePageParams(const httplib::Request& req);
+
+// ?includeArchived=true also returns orders moved to the archive database.
+bool wantsArchived(const httplib::Request& req);
+
+#endif // PAGE_PARAMS_H
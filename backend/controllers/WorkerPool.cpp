@@ -0,0 +1,110 @@
+#include "WorkerPool.h"
+#include <algorithm>
+
+namespace {
+	thread_local WorkerPool* currentPool = nullptr;
+}
+
+WorkerPool::WorkerPool(size_t workers, size_t maxStreams) : workers(workers), maxStreams(maxStreams) {
+	std::lock_guard<std::mutex> lock(mutex);
+	for (size_t i = 0; i < workers; ++i) {
+		startWorkerLocked();
+	}
+}
+
+WorkerPool::~WorkerPool() {
+	shutdown();
+}
+
+bool WorkerPool::enqueue(std::function<void()> fn) {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (stopping) {
+			return false;
+		}
+		joinExitedLocked();
+		tasks.push_back(std::move(fn));
+	}
+	ready.notify_one();
+	return true;
+}
+
+void WorkerPool::shutdown() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	ready.notify_all();
+	// Nothing adds threads once stopping is set.
+	for (auto& thread : threads) {
+		thread.join();
+	}
+	threads.clear();
+}
+
+WorkerPool* WorkerPool::current() {
+	return currentPool;
+}
+
+bool WorkerPool::enterStream() {
+	std::lock_guard<std::mutex> lock(mutex);
+	if (stopping || streaming >= maxStreams) {
+		return false;
+	}
+	++streaming;
+	joinExitedLocked();
+	if (running - streaming < workers) {
+		startWorkerLocked();
+	}
+	return true;
+}
+
+void WorkerPool::leaveStream() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		--streaming;
+	}
+	// Lets one idle worker notice it is now surplus.
+	ready.notify_one();
+}
+
+void WorkerPool::work() {
+	currentPool = this;
+	for (;;) {
+		std::function<void()> task;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			ready.wait(lock, [this] { return stopping || !tasks.empty() || running - streaming > workers; });
+			if (tasks.empty()) {
+				// Shutting down, or a stream ended and this worker is spare.
+				--running;
+				exited.push_back(std::this_thread::get_id());
+				return;
+			}
+			task = std::move(tasks.front());
+			tasks.pop_front();
+		}
+		task();
+	}
+}
+
+void WorkerPool::startWorkerLocked() {
+	threads.emplace_back(&WorkerPool::work, this);
+	++running;
+}
+
+// An exited thread no longer needs the mutex, so joining under it is safe.
+void WorkerPool::joinExitedLocked() {
+	if (exited.empty()) {
+		return;
+	}
+	for (auto it = threads.begin(); it != threads.end();) {
+		if (std::find(exited.begin(), exited.end(), it->get_id()) != exited.end()) {
+			it->join();
+			it = threads.erase(it);
+		} else {
+			++it;
+		}
+	}
+	exited.clear();
+}
@@ -0,0 +1,55 @@
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+#include <httplib.h>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Server task queue that keeps a fixed number of workers free for ordinary
+// requests however many long-lived streams are open. httplib writes a
+// response on the worker serving the connection, so a stream holds that
+// thread until it ends; the handler calls enterStream() first and the pool
+// starts a stand-in worker, at most maxStreams of them. Stand-ins start on
+// demand and exit once a stream ends and they are left idle.
+class WorkerPool : public httplib::TaskQueue {
+public:
+	WorkerPool(size_t workers, size_t maxStreams);
+	~WorkerPool() override;
+
+	bool enqueue(std::function<void()> fn) override;
+	// Runs the queued tasks, then joins every thread. Idempotent.
+	void shutdown() override;
+
+	// The pool whose worker is calling, or nullptr off the server workers.
+	static WorkerPool* current();
+	// Call on a worker about to block in a stream. False when maxStreams
+	// streams are already open; the caller should refuse the stream.
+	bool enterStream();
+	// Pairs with a successful enterStream(); any thread.
+	void leaveStream();
+
+private:
+	void work();
+	// Caller holds mutex.
+	void startWorkerLocked();
+	void joinExitedLocked();
+
+	const size_t workers;
+	const size_t maxStreams;
+	std::mutex mutex;
+	std::condition_variable ready;
+	std::deque<std::function<void()>> tasks;
+	std::list<std::thread> threads;
+	// Threads that returned from work() but are not joined yet.
+	std::vector<std::thread::id> exited;
+	size_t running{0};
+	size_t streaming{0};
+	bool stopping{false};
+};
+
+#endif // WORKER_POOL_H
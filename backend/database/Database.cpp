@@ -1,5 +1,204 @@
 #include "Database.h"
+#include "Migrations.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
 #include <stdexcept>
+#include <thread>
+
+namespace {
+	// One read snapshot across several statements on a lease: a single shared
+	// lock and a consistent view instead of one implicit transaction per
+	// statement. Declare it before the statements so they are reset before it
+	// commits. A no-op when the connection is already in a transaction (reader()
+	// hands out the writer when there is no reader pool).
+	class ReadTransaction {
+	public:
+		explicit ReadTransaction(const ConnectionLease& conn) : conn(conn) {}
+		~ReadTransaction() {
+			if (active) {
+				std::string ignored;
+				run("COMMIT;", ignored);
+			}
+		}
+		ReadTransaction(const ReadTransaction&) = delete;
+		ReadTransaction& operator=(const ReadTransaction&) = delete;
+
+		bool begin(std::string& errMsg) {
+			if (!sqlite3_get_autocommit(conn.db())) {
+				return true;
+			}
+			active = run("BEGIN DEFERRED;", errMsg);
+			return active;
+		}
+
+	private:
+		bool run(const char* sql, std::string& errMsg) {
+			StatementHandle stmt(conn.statements().acquire(sql, errMsg));
+			if (!stmt) {
+				return false;
+			}
+			if (sqlite3_step(stmt) != SQLITE_DONE) {
+				errMsg = sqlite3_errmsg(conn.db());
+				return false;
+			}
+			return true;
+		}
+
+		const ConnectionLease& conn;
+		bool active{false};
+	};
+
+	constexpr int kBusyRetries = 5000;
+
+	constexpr char kOrderItemsSql[] = "SELECT dish_id, quantity, unit_price FROM order_items WHERE order_id = ? ORDER BY id;";
+	constexpr char kOrdersByUserSql[] =
+		"SELECT o.id, o.status, o.total, o.user_id, o.pickup_notified, o.created_at, o.updated_at, "
+		"i.dish_id, i.quantity, i.unit_price "
+		"FROM orders o LEFT JOIN order_items i ON i.order_id = o.id "
+		"WHERE o.user_id = ? "
+		"ORDER BY o.id DESC, i.id;";
+	// Events applied to SQLite per transaction, by the applier and on replay.
+	constexpr size_t kEventApplyBatch = 256;
+
+	constexpr char kAddDishSalesSql[] =
+		"INSERT INTO dish_sales(day, dish_id, quantity, revenue) VALUES(?,?,?,?) "
+		"ON CONFLICT(day, dish_id) DO UPDATE SET quantity = quantity + excluded.quantity, revenue = revenue + excluded.revenue;";
+	// Keyset pages: the newest `limit` orders below a cursor id, then their items.
+	constexpr char kOrdersPageSql[] =
+		"SELECT o.id, o.status, o.total, o.user_id, o.pickup_notified, o.created_at, o.updated_at, "
+		"i.dish_id, i.quantity, i.unit_price "
+		"FROM (SELECT * FROM orders WHERE id < ? ORDER BY id DESC LIMIT ?) o "
+		"LEFT JOIN order_items i ON i.order_id = o.id "
+		"ORDER BY o.id DESC, i.id;";
+	constexpr char kOrdersByUserPageSql[] =
+		"SELECT o.id, o.status, o.total, o.user_id, o.pickup_notified, o.created_at, o.updated_at, "
+		"i.dish_id, i.quantity, i.unit_price "
+		"FROM (SELECT * FROM orders WHERE user_id = ? AND id < ? ORDER BY id DESC LIMIT ?) o "
+		"LEFT JOIN order_items i ON i.order_id = o.id "
+		"ORDER BY o.id DESC, i.id;";
+
+	// Orders still waiting on the kitchen or on pickup acknowledgement.
+	constexpr char kActiveOrdersSql[] =
+		"SELECT o.id, o.status, o.total, o.user_id, o.pickup_notified, o.created_at, o.updated_at, "
+		"i.dish_id, i.quantity, i.unit_price "
+		"FROM orders o LEFT JOIN order_items i ON i.order_id = o.id "
+		"WHERE o.status IN ('pending', 'preparing', 'ready') OR (o.status = 'completed' AND o.pickup_notified = 0) "
+		"ORDER BY o.id DESC, i.id;";
+	constexpr char kDeleteExpiredSessionsSql[] =
+		"DELETE FROM sessions WHERE id IN (SELECT id FROM sessions WHERE expires_at <= ? LIMIT ?);";
+
+	struct IndexedQuery {
+		const char* index;
+		const char* sql;
+	};
+
+	// Hot queries and the index each one must be planned with.
+	const IndexedQuery kIndexedQueries[] = {
+		{"idx_order_items_order_id", kOrderItemsSql},
+		{"idx_orders_user_id", kOrdersByUserSql},
+		{"idx_orders_user_id", kOrdersByUserPageSql},
+		{"idx_orders_status_id", kActiveOrdersSql},
+		{"idx_sessions_expires_at", kDeleteExpiredSessionsSql},
+	};
+
+	// sqlite3_busy_timeout backs off up to 100ms per retry. WAL readers only
+	// see short BUSY windows around checkpoints, so poll every millisecond.
+	int retryWhenBusy(void*, int attempts) {
+		if (attempts >= kBusyRetries) return 0;
+		sqlite3_sleep(1);
+		return 1;
+	}
+
+	// Expects rows of an orders LEFT JOIN order_items query sorted by order id:
+	// columns 0-6 are the order header, 7-9 the item (NULL for orders without
+	// items). Groups the items into their orders in a single pass.
+	std::vector<Order> readOrdersWithItems(sqlite3_stmt* stmt) {
+		std::vector<Order> result;
+		while (sqlite3_step(stmt) == SQLITE_ROW) {
+			const int orderId = sqlite3_column_int(stmt, 0);
+			if (result.empty() || result.back().id != orderId) {
+				Order order{};
+				order.id = orderId;
+				order.status = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
+				order.total = sqlite3_column_double(stmt, 2);
+				if (sqlite3_column_type(stmt, 3) != SQLITE_NULL) {
+					order.userId = sqlite3_column_int(stmt, 3);
+				}
+				order.pickupNotified = sqlite3_column_int(stmt, 4) != 0;
+				order.createdAt = sqlite3_column_int64(stmt, 5);
+				order.updatedAt = sqlite3_column_int64(stmt, 6);
+				result.push_back(std::move(order));
+			}
+			if (sqlite3_column_type(stmt, 7) != SQLITE_NULL) {
+				OrderItem it;
+				it.dishId = sqlite3_column_int(stmt, 7);
+				it.quantity = sqlite3_column_int(stmt, 8);
+				it.unitPrice = sqlite3_column_double(stmt, 9);
+				result.back().items.push_back(it);
+			}
+		}
+		return result;
+	}
+
+	constexpr char kArchiveSchema[] = R"SQL(
+		CREATE TABLE IF NOT EXISTS archive.orders (
+			id INTEGER PRIMARY KEY,
+			user_id INTEGER,
+			status TEXT NOT NULL,
+			total REAL NOT NULL,
+			pickup_notified INTEGER NOT NULL,
+			created_at INTEGER NOT NULL,
+			updated_at INTEGER NOT NULL
+		);
+		CREATE TABLE IF NOT EXISTS archive.order_items (
+			id INTEGER PRIMARY KEY,
+			order_id INTEGER NOT NULL,
+			dish_id INTEGER NOT NULL,
+			quantity INTEGER NOT NULL,
+			unit_price REAL NOT NULL
+		);
+		CREATE INDEX IF NOT EXISTS archive.idx_order_items_order_id ON order_items(order_id);
+		CREATE INDEX IF NOT EXISTS archive.idx_orders_user_id ON orders(user_id, id DESC);
+		CREATE TEMP TABLE IF NOT EXISTS archive_batch (id INTEGER PRIMARY KEY);
+	)SQL";
+
+	// The same order query against the attached archive tables.
+	std::string archiveSql(const std::string& sql) {
+		std::string result = sql;
+		for (const std::string table : {"orders", "order_items"}) {
+			for (const std::string keyword : {"FROM ", "JOIN "}) {
+				const std::string from = keyword + table + " ";
+				const std::string to = keyword + "archive." + table + " ";
+				for (size_t pos = result.find(from); pos != std::string::npos; pos = result.find(from, pos + to.size())) {
+					result.replace(pos, from.size(), to);
+				}
+			}
+		}
+		return result;
+	}
+
+	// Both inputs newest first. Live rows win if a crash between the two
+	// databases' commits left an order in both.
+	std::vector<Order> mergeNewestFirst(std::vector<Order> live, std::vector<Order> archived, int limit) {
+		std::vector<Order> result;
+		result.reserve(live.size() + archived.size());
+		size_t a = 0;
+		size_t b = 0;
+		while (a < live.size() || b < archived.size()) {
+			if (limit > 0 && static_cast<int>(result.size()) >= limit) break;
+			if (b == archived.size() || (a < live.size() && live[a].id >= archived[b].id)) {
+				if (b < archived.size() && archived[b].id == live[a].id) ++b;
+				result.push_back(std::move(live[a++]));
+			} else {
+				result.push_back(std::move(archived[b++]));
+			}
+		}
+		return result;
+	}
+}
 
 Database::~Database() {
 	close();
@@ -10,173 +209,175 @@ Database& Database::instance() {
 	return inst;
 }
 
-bool Database::open(const std::string& path, std::string& errMsg) {
-	if (db) return true;
-	int rc = sqlite3_open(path.c_str(), &db);
+bool Database::open(const std::string& path, std::string& errMsg, int readerConnections) {
+	auto conn = writer();
+	if (writerConn.db) return true;
+	int rc = sqlite3_open_v2(path.c_str(), &writerConn.db,
+		SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE | SQLITE_OPEN_NOMUTEX, nullptr);
 	if (rc != SQLITE_OK) {
-		errMsg = sqlite3_errmsg(db);
+		errMsg = sqlite3_errmsg(writerConn.db);
 		close();
 		return false;
 	}
+	sqlite3_busy_handler(writerConn.db, retryWhenBusy, nullptr);
 	// Enforce foreign keys
 	char* em = nullptr;
-	sqlite3_exec(db, "PRAGMA foreign_keys = ON;", nullptr, nullptr, &em);
+	sqlite3_exec(writerConn.db, "PRAGMA foreign_keys = ON;", nullptr, nullptr, &em);
 	if (em) sqlite3_free(em);
+	writerConn.statements.attach(writerConn.db);
 
 	// Initialize schema if tables don't exist
-	if (!initializeSchema(errMsg)) {
+	if (!initializeSchema(errMsg) || !verifyIndexUsage(errMsg) || !loadDishTable(conn, errMsg)) {
 		close();
 		return false;
 	}
 
-	return true;
-}
-
-void Database::close() {
-	if (db) {
-		sqlite3_close(db);
-		db = nullptr;
+	if (readerConnections > 0 && !openReaders(path, readerConnections, errMsg)) {
+		close();
+		return false;
 	}
+
+	return true;
 }
 
-bool Database::initializeSchema(std::string& errMsg) {
-	// Check if dishes table exists
-	const char* checkTable = "SELECT name FROM sqlite_master WHERE type='table' AND name='dishes';";
+bool Database::openReaders(const std::string& path, int count, std::string& errMsg) {
+	// Readers only help when they do not block on the writer, which needs WAL.
+	std::string mode;
 	sqlite3_stmt* stmt = nullptr;
-	bool tableExists = false;
-	if (sqlite3_prepare_v2(db, checkTable, -1, &stmt, nullptr) == SQLITE_OK) {
+	if (sqlite3_prepare_v2(writerConn.db, "PRAGMA journal_mode = WAL;", -1, &stmt, nullptr) == SQLITE_OK) {
 		if (sqlite3_step(stmt) == SQLITE_ROW) {
-			tableExists = true;
+			const auto* text = sqlite3_column_text(stmt, 0);
+			mode = text ? reinterpret_cast<const char*>(text) : "";
 		}
 		sqlite3_finalize(stmt);
 	}
+	if (mode != "wal") {
+		// e.g. in-memory databases; keep serving reads from the writer
+		printf("WAL unavailable (journal_mode=%s), reads use the writer connection\n", mode.c_str());
+		return true;
+	}
 
-	// Always create tables (CREATE TABLE IF NOT EXISTS is safe)
-	char* em = nullptr;
-	const char* schema = R"SQL(
-		CREATE TABLE IF NOT EXISTS users (
-			id INTEGER PRIMARY KEY,
-			username TEXT NOT NULL UNIQUE,
-			password_hash TEXT NOT NULL,
-			phone TEXT,
-			created_at TEXT NOT NULL DEFAULT CURRENT_TIMESTAMP
-		);
-		CREATE TABLE IF NOT EXISTS merchants (
-			id INTEGER PRIMARY KEY,
-			username TEXT NOT NULL UNIQUE,
-			password_hash TEXT NOT NULL,
-			store_name TEXT,
-			created_at TEXT NOT NULL DEFAULT CURRENT_TIMESTAMP
-		);
-		CREATE TABLE IF NOT EXISTS sessions (
-			id INTEGER PRIMARY KEY,
-			token TEXT NOT NULL UNIQUE,
-			user_id INTEGER,
-			merchant_id INTEGER,
-			expires_at TEXT NOT NULL,
-			created_at TEXT NOT NULL DEFAULT CURRENT_TIMESTAMP,
-			FOREIGN KEY(user_id) REFERENCES users(id) ON DELETE CASCADE,
-			FOREIGN KEY(merchant_id) REFERENCES merchants(id) ON DELETE CASCADE
-		);
-		CREATE TABLE IF NOT EXISTS dishes (
-			id INTEGER PRIMARY KEY,
-			name TEXT NOT NULL,
-			description TEXT,
-			category TEXT,
-			price REAL NOT NULL,
-			is_available INTEGER NOT NULL DEFAULT 1,
-			created_at TEXT NOT NULL DEFAULT CURRENT_TIMESTAMP,
-			updated_at TEXT NOT NULL DEFAULT CURRENT_TIMESTAMP
-		);
-		CREATE TABLE IF NOT EXISTS orders (
-			id INTEGER PRIMARY KEY,
-			user_id INTEGER,
-			status TEXT NOT NULL DEFAULT 'pending',
-			total REAL NOT NULL DEFAULT 0,
-			pickup_notified INTEGER NOT NULL DEFAULT 0,
-			created_at TEXT NOT NULL DEFAULT CURRENT_TIMESTAMP,
-			updated_at TEXT NOT NULL DEFAULT CURRENT_TIMESTAMP,
-			FOREIGN KEY(user_id) REFERENCES users(id) ON DELETE SET NULL
-		);
-		CREATE TABLE IF NOT EXISTS order_items (
-			id INTEGER PRIMARY KEY,
-			order_id INTEGER NOT NULL,
-			dish_id INTEGER NOT NULL,
-			quantity INTEGER NOT NULL,
-			unit_price REAL NOT NULL,
-			FOREIGN KEY(order_id) REFERENCES orders(id) ON DELETE CASCADE,
-			FOREIGN KEY(dish_id) REFERENCES dishes(id)
-		);
-	)SQL";
-	
-	if (sqlite3_exec(db, schema, nullptr, nullptr, &em) != SQLITE_OK) {
-		if (em) {
-			errMsg = em;
-			sqlite3_free(em);
-		} else {
-			errMsg = "Failed to create database schema";
+	for (int i = 0; i < count; ++i) {
+		auto conn = std::make_unique<DbConnection>();
+		if (sqlite3_open_v2(path.c_str(), &conn->db, SQLITE_OPEN_READONLY | SQLITE_OPEN_NOMUTEX, nullptr) != SQLITE_OK) {
+			errMsg = sqlite3_errmsg(conn->db);
+			sqlite3_close(conn->db);
+			return false;
+		}
+		sqlite3_busy_handler(conn->db, retryWhenBusy, nullptr);
+		conn->statements.attach(conn->db);
+		readers.push_back(std::move(conn));
+	}
+	return true;
+}
+
+void Database::close() {
+	// Let queued orders commit before the writer connection goes away.
+	groupCommit.reset();
+	stopEventLog();
+
+	for (auto& reader : readers) {
+		std::lock_guard<std::recursive_mutex> lock(reader->mutex);
+		reader->statements.clear();
+		sqlite3_close(reader->db);
+	}
+	readers.clear();
+
+	auto conn = writer();
+	writerConn.statements.clear();
+	if (writerConn.db) {
+		sqlite3_close(writerConn.db);
+		writerConn.db = nullptr;
+	}
+	dishTable.clear();
+}
+
+ConnectionLease Database::writer() {
+	return ConnectionLease(writerConn, std::unique_lock<std::recursive_mutex>(writerConn.mutex));
+}
+
+ConnectionLease Database::reader() {
+	if (readers.empty()) {
+		return writer();
+	}
+	// Take the first idle reader, starting at a rotating offset; if all are
+	// busy, wait on the one the rotation points at.
+	const size_t start = nextReader.fetch_add(1, std::memory_order_relaxed);
+	for (size_t i = 0; i < readers.size(); ++i) {
+		auto& conn = *readers[(start + i) % readers.size()];
+		std::unique_lock<std::recursive_mutex> lock(conn.mutex, std::try_to_lock);
+		if (lock.owns_lock()) {
+			return ConnectionLease(conn, std::move(lock));
 		}
+	}
+	auto& conn = *readers[start % readers.size()];
+	return ConnectionLease(conn, std::unique_lock<std::recursive_mutex>(conn.mutex));
+}
+
+bool Database::initializeSchema(std::string& errMsg) {
+	auto conn = writer();
+	sqlite3* db = conn.db();
+
+	int version = 0;
+	sqlite3_stmt* stmt = nullptr;
+	if (sqlite3_prepare_v2(db, "PRAGMA user_version;", -1, &stmt, nullptr) != SQLITE_OK) {
+		errMsg = sqlite3_errmsg(db);
 		return false;
 	}
+	if (sqlite3_step(stmt) == SQLITE_ROW) {
+		version = sqlite3_column_int(stmt, 0);
+	}
+	sqlite3_finalize(stmt);
 
-	// Verify table was created
-	if (sqlite3_prepare_v2(db, checkTable, -1, &stmt, nullptr) == SQLITE_OK) {
-		tableExists = (sqlite3_step(stmt) == SQLITE_ROW);
-		sqlite3_finalize(stmt);
+	// Fast path: an up-to-date database runs no DDL at all.
+	if (version == latestSchemaVersion()) {
+		return true;
 	}
-	
-	if (!tableExists) {
-		errMsg = "Table 'dishes' was not created after schema execution";
+	if (version > latestSchemaVersion()) {
+		errMsg = "database schema version " + std::to_string(version) + " is newer than this build supports";
 		return false;
 	}
 
-	// Initialize data if table is empty
-	if (!hasInitialData()) {
-		if (!insertInitialData(errMsg)) {
+	for (const auto& migration : schemaMigrations()) {
+		if (migration.version <= version) continue;
+		const std::string script = std::string("BEGIN IMMEDIATE;") + migration.sql +
+			"PRAGMA user_version = " + std::to_string(migration.version) + ";COMMIT;";
+		char* em = nullptr;
+		if (sqlite3_exec(db, script.c_str(), nullptr, nullptr, &em) != SQLITE_OK) {
+			errMsg = "migration " + std::to_string(migration.version) + " (" + migration.description + ") failed: " +
+				(em ? em : sqlite3_errmsg(db));
+			if (em) sqlite3_free(em);
+			sqlite3_exec(db, "ROLLBACK;", nullptr, nullptr, nullptr);
 			return false;
 		}
+		printf("Applied schema migration %d: %s\n", migration.version, migration.description);
 	}
-
 	return true;
 }
 
-bool Database::hasInitialData() {
-	const char* checkData = "SELECT COUNT(*) FROM dishes;";
-	sqlite3_stmt* stmt = nullptr;
-	int count = 0;
-	if (sqlite3_prepare_v2(db, checkData, -1, &stmt, nullptr) == SQLITE_OK) {
-		if (sqlite3_step(stmt) == SQLITE_ROW) {
-			count = sqlite3_column_int(stmt, 0);
+bool Database::verifyIndexUsage(std::string& errMsg) {
+	auto conn = writer();
+	for (const auto& query : kIndexedQueries) {
+		const std::string explain = std::string("EXPLAIN QUERY PLAN ") + query.sql;
+		const std::string needle = std::string("INDEX ") + query.index;
+		sqlite3_stmt* stmt = nullptr;
+		if (sqlite3_prepare_v2(conn.db(), explain.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+			errMsg = sqlite3_errmsg(conn.db());
+			return false;
+		}
+		std::string plan;
+		bool usesIndex = false;
+		while (sqlite3_step(stmt) == SQLITE_ROW) {
+			const auto* detail = sqlite3_column_text(stmt, 3);
+			const std::string line = detail ? reinterpret_cast<const char*>(detail) : "";
+			usesIndex = usesIndex || line.find(needle) != std::string::npos;
+			plan += (plan.empty() ? "" : "; ") + line;
 		}
 		sqlite3_finalize(stmt);
-	}
-	return count > 0;
-}
-
-bool Database::insertInitialData(std::string& errMsg) {
-	char* em = nullptr;
-	const char* initData =
-		"INSERT INTO dishes (id, name, description, category, price, is_available) VALUES"
-		"	(1, 'Margherita Pizza', 'Classic tomato, mozzarella and basil', 'Pizza', 8.5, 1),"
-		"	(2, 'Caesar Salad', 'Romaine lettuce with parmesan and croutons', 'Salad', 6.0, 1),"
-		"	(3, 'Spaghetti Bolognese', 'Slow cooked beef ragu', 'Pasta', 9.5, 1),"
-		"	(4, 'Cheeseburger', 'Beef patty, cheddar, pickles', 'Burger', 7.5, 1),"
-		"	(5, 'Chicken Caesar Salad', 'Grilled chicken with Caesar dressing', 'Salad', 8.0, 1),"
-		"	(6, 'Vegetable Stir Fry', 'Seasonal veggies with soy glaze', 'Wok', 6.5, 1),"
-		"	(7, 'Fish and Chips', 'Beer battered cod with fries', 'Seafood', 10.0, 1),"
-		"	(8, 'Tiramisu', 'Espresso soaked ladyfingers and mascarpone', 'Dessert', 5.5, 1),"
-		"	(9, 'Lemonade', 'Freshly squeezed lemon juice', 'Drinks', 3.0, 1),"
-		"	(10, 'Tomato Soup', 'Roasted tomato soup with basil oil', 'Soup', 5.0, 1)"
-		"ON CONFLICT(id) DO NOTHING;";
-
-	if (sqlite3_exec(db, initData, nullptr, nullptr, &em) != SQLITE_OK) {
-		if (em) {
-			errMsg = em;
-			sqlite3_free(em);
-		} else {
-			errMsg = "Failed to insert initial data";
+		if (!usesIndex) {
+			errMsg = std::string("query does not use ") + query.index + ": " + query.sql + " [plan: " + plan + "]";
+			return false;
 		}
-		return false;
 	}
 	return true;
 }
@@ -184,9 +385,9 @@ bool Database::insertInitialData(std::string& errMsg) {
 std::vector<Dish> Database::getAllDishes(std::string& errMsg) {
 	std::vector<Dish> result;
 	const char* sql = "SELECT id, name, description, category, price, is_available FROM dishes ORDER BY id;";
-	sqlite3_stmt* stmt = nullptr;
-	if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
-		errMsg = sqlite3_errmsg(db);
+	auto conn = reader();
+	StatementHandle stmt(conn.statements().acquire(sql, errMsg));
+	if (!stmt) {
 		return result;
 	}
 	while (sqlite3_step(stmt) == SQLITE_ROW) {
@@ -201,20 +402,43 @@ std::vector<Dish> Database::getAllDishes(std::string& errMsg) {
 		d.isAvailable = sqlite3_column_int(stmt, 5) != 0;
 		result.push_back(std::move(d));
 	}
-	sqlite3_finalize(stmt);
+	return result;
+}
+
+std::vector<Dish> Database::getDishesPage(int afterId, int limit, std::string& errMsg) {
+	std::vector<Dish> result;
+	const char* sql = "SELECT id, name, description, category, price, is_available FROM dishes WHERE id > ? ORDER BY id LIMIT ?;";
+	auto conn = reader();
+	StatementHandle stmt(conn.statements().acquire(sql, errMsg));
+	if (!stmt) {
+		return result;
+	}
+	sqlite3_bind_int(stmt, 1, afterId);
+	sqlite3_bind_int(stmt, 2, limit);
+	while (sqlite3_step(stmt) == SQLITE_ROW) {
+		Dish d;
+		d.id = sqlite3_column_int(stmt, 0);
+		d.name = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
+		const auto* desc = sqlite3_column_text(stmt, 2);
+		d.description = desc ? reinterpret_cast<const char*>(desc) : "";
+		const auto* cat = sqlite3_column_text(stmt, 3);
+		d.category = cat ? reinterpret_cast<const char*>(cat) : "";
+		d.price = sqlite3_column_double(stmt, 4);
+		d.isAvailable = sqlite3_column_int(stmt, 5) != 0;
+		result.push_back(std::move(d));
+	}
 	return result;
 }
 
 std::optional<Dish> Database::getDish(int dishId, std::string& errMsg) {
 	const char* sql = "SELECT id, name, description, category, price, is_available FROM dishes WHERE id = ?;";
-	sqlite3_stmt* stmt = nullptr;
-	if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
-		errMsg = sqlite3_errmsg(db);
+	auto conn = reader();
+	StatementHandle stmt(conn.statements().acquire(sql, errMsg));
+	if (!stmt) {
 		return std::nullopt;
 	}
 	sqlite3_bind_int(stmt, 1, dishId);
 	if (sqlite3_step(stmt) != SQLITE_ROW) {
-		sqlite3_finalize(stmt);
 		return std::nullopt;
 	}
 	Dish d;
@@ -226,15 +450,14 @@ std::optional<Dish> Database::getDish(int dishId, std::string& errMsg) {
 	d.category = cat ? reinterpret_cast<const char*>(cat) : "";
 	d.price = sqlite3_column_double(stmt, 4);
 	d.isAvailable = sqlite3_column_int(stmt, 5) != 0;
-	sqlite3_finalize(stmt);
 	return d;
 }
 
 std::optional<int> Database::createDish(const Dish& dish, std::string& errMsg) {
 	const char* sql = "INSERT INTO dishes(name, description, category, price, is_available) VALUES(?,?,?,?,?);";
-	sqlite3_stmt* stmt = nullptr;
-	if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
-		errMsg = sqlite3_errmsg(db);
+	auto conn = writer();
+	StatementHandle stmt(conn.statements().acquire(sql, errMsg));
+	if (!stmt) {
 		return std::nullopt;
 	}
 	sqlite3_bind_text(stmt, 1, dish.name.c_str(), -1, SQLITE_STATIC);
@@ -243,12 +466,62 @@ std::optional<int> Database::createDish(const Dish& dish, std::string& errMsg) {
 	sqlite3_bind_double(stmt, 4, dish.price);
 	sqlite3_bind_int(stmt, 5, dish.isAvailable ? 1 : 0);
 	if (sqlite3_step(stmt) != SQLITE_DONE) {
-		errMsg = sqlite3_errmsg(db);
-		sqlite3_finalize(stmt);
+		errMsg = sqlite3_errmsg(conn.db());
 		return std::nullopt;
 	}
-	sqlite3_finalize(stmt);
-	return static_cast<int>(sqlite3_last_insert_rowid(db));
+	const int id = static_cast<int>(sqlite3_last_insert_rowid(conn.db()));
+	dishTable.set({DishPrice{id, dish.price, dish.isAvailable}});
+	return id;
+}
+
+std::optional<int> Database::upsertDishes(const std::vector<Dish>& dishes, std::string& errMsg) {
+	const char* sql =
+		"INSERT INTO dishes(id, name, description, category, price, is_available) VALUES(?,?,?,?,?,?) "
+		"ON CONFLICT(id) DO UPDATE SET name = excluded.name, description = excluded.description, "
+		"category = excluded.category, price = excluded.price, is_available = excluded.is_available, "
+		"updated_at = CURRENT_TIMESTAMP;";
+	auto conn = writer();
+	if (!execCached(conn, "BEGIN IMMEDIATE;", errMsg)) {
+		return std::nullopt;
+	}
+	auto fail = [&]() -> std::optional<int> {
+		std::string ignored;
+		execCached(conn, "ROLLBACK;", ignored);
+		return std::nullopt;
+	};
+	std::vector<DishPrice> written;
+	written.reserve(dishes.size());
+	{
+		StatementHandle stmt(conn.statements().acquire(sql, errMsg));
+		if (!stmt) {
+			return fail();
+		}
+		for (const auto& dish : dishes) {
+			if (dish.id > 0) {
+				sqlite3_bind_int(stmt, 1, dish.id);
+			} else {
+				sqlite3_bind_null(stmt, 1);
+			}
+			sqlite3_bind_text(stmt, 2, dish.name.c_str(), -1, SQLITE_STATIC);
+			sqlite3_bind_text(stmt, 3, dish.description.c_str(), -1, SQLITE_STATIC);
+			sqlite3_bind_text(stmt, 4, dish.category.c_str(), -1, SQLITE_STATIC);
+			sqlite3_bind_double(stmt, 5, dish.price);
+			sqlite3_bind_int(stmt, 6, dish.isAvailable ? 1 : 0);
+			if (sqlite3_step(stmt) != SQLITE_DONE) {
+				errMsg = sqlite3_errmsg(conn.db());
+				return fail();
+			}
+			const int id = dish.id > 0 ? dish.id : static_cast<int>(sqlite3_last_insert_rowid(conn.db()));
+			written.push_back(DishPrice{id, dish.price, dish.isAvailable});
+			sqlite3_reset(stmt);
+			sqlite3_clear_bindings(stmt);
+		}
+	}
+	if (!execCached(conn, "COMMIT;", errMsg)) {
+		return fail();
+	}
+	dishTable.set(written);
+	return static_cast<int>(dishes.size());
 }
 
 bool Database::updateDish(int dishId,
@@ -285,9 +558,9 @@ bool Database::updateDish(int dishId,
 	}
 	sql += ", updated_at = CURRENT_TIMESTAMP WHERE id = ?;";
 
-	sqlite3_stmt* stmt = nullptr;
-	if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
-		errMsg = sqlite3_errmsg(db);
+	auto conn = writer();
+	StatementHandle stmt(conn.statements().acquire(sql, errMsg));
+	if (!stmt) {
 		return false;
 	}
 
@@ -309,19 +582,18 @@ bool Database::updateDish(int dishId,
 	sqlite3_bind_int(stmt, bindIdx, dishId);
 
 	if (sqlite3_step(stmt) != SQLITE_DONE) {
-		errMsg = sqlite3_errmsg(db);
-		sqlite3_finalize(stmt);
+		errMsg = sqlite3_errmsg(conn.db());
 		return false;
 	}
-	sqlite3_finalize(stmt);
+	dishTable.update(dishId, price, isAvailable);
 	return true;
 }
 
 bool Database::createUser(const std::string& username, const std::string& passwordHash, const std::string& phone, std::string& errMsg) {
 	const char* sql = "INSERT INTO users(username, password_hash, phone) VALUES(?,?,?);";
-	sqlite3_stmt* stmt = nullptr;
-	if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
-		errMsg = sqlite3_errmsg(db);
+	auto conn = writer();
+	StatementHandle stmt(conn.statements().acquire(sql, errMsg));
+	if (!stmt) {
 		return false;
 	}
 	sqlite3_bind_text(stmt, 1, username.c_str(), -1, SQLITE_STATIC);
@@ -329,17 +601,16 @@ bool Database::createUser(const std::string& username, const std::string& passwo
 	sqlite3_bind_text(stmt, 3, phone.c_str(), -1, SQLITE_STATIC);
 	bool ok = sqlite3_step(stmt) == SQLITE_DONE;
 	if (!ok) {
-		errMsg = sqlite3_errmsg(db);
+		errMsg = sqlite3_errmsg(conn.db());
 	}
-	sqlite3_finalize(stmt);
 	return ok;
 }
 
 bool Database::createMerchant(const std::string& username, const std::string& passwordHash, const std::string& storeName, std::string& errMsg) {
 	const char* sql = "INSERT INTO merchants(username, password_hash, store_name) VALUES(?,?,?);";
-	sqlite3_stmt* stmt = nullptr;
-	if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
-		errMsg = sqlite3_errmsg(db);
+	auto conn = writer();
+	StatementHandle stmt(conn.statements().acquire(sql, errMsg));
+	if (!stmt) {
 		return false;
 	}
 	sqlite3_bind_text(stmt, 1, username.c_str(), -1, SQLITE_STATIC);
@@ -347,22 +618,20 @@ bool Database::createMerchant(const std::string& username, const std::string& pa
 	sqlite3_bind_text(stmt, 3, storeName.c_str(), -1, SQLITE_STATIC);
 	bool ok = sqlite3_step(stmt) == SQLITE_DONE;
 	if (!ok) {
-		errMsg = sqlite3_errmsg(db);
+		errMsg = sqlite3_errmsg(conn.db());
 	}
-	sqlite3_finalize(stmt);
 	return ok;
 }
 
 std::optional<User> Database::getUserByUsername(const std::string& username, std::string& errMsg) {
 	const char* sql = "SELECT id, username, password_hash, phone, created_at FROM users WHERE username = ?;";
-	sqlite3_stmt* stmt = nullptr;
-	if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
-		errMsg = sqlite3_errmsg(db);
+	auto conn = reader();
+	StatementHandle stmt(conn.statements().acquire(sql, errMsg));
+	if (!stmt) {
 		return std::nullopt;
 	}
 	sqlite3_bind_text(stmt, 1, username.c_str(), -1, SQLITE_STATIC);
 	if (sqlite3_step(stmt) != SQLITE_ROW) {
-		sqlite3_finalize(stmt);
 		return std::nullopt;
 	}
 	User u;
@@ -373,20 +642,18 @@ std::optional<User> Database::getUserByUsername(const std::string& username, std
 	u.phone = phone ? reinterpret_cast<const char*>(phone) : "";
 	const auto* created = sqlite3_column_text(stmt, 4);
 	u.createdAt = created ? reinterpret_cast<const char*>(created) : "";
-	sqlite3_finalize(stmt);
 	return u;
 }
 
 std::optional<Merchant> Database::getMerchantByUsername(const std::string& username, std::string& errMsg) {
 	const char* sql = "SELECT id, username, password_hash, store_name, created_at FROM merchants WHERE username = ?;";
-	sqlite3_stmt* stmt = nullptr;
-	if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
-		errMsg = sqlite3_errmsg(db);
+	auto conn = reader();
+	StatementHandle stmt(conn.statements().acquire(sql, errMsg));
+	if (!stmt) {
 		return std::nullopt;
 	}
 	sqlite3_bind_text(stmt, 1, username.c_str(), -1, SQLITE_STATIC);
 	if (sqlite3_step(stmt) != SQLITE_ROW) {
-		sqlite3_finalize(stmt);
 		return std::nullopt;
 	}
 	Merchant m;
@@ -397,20 +664,18 @@ std::optional<Merchant> Database::getMerchantByUsername(const std::string& usern
 	m.storeName = store ? reinterpret_cast<const char*>(store) : "";
 	const auto* created = sqlite3_column_text(stmt, 4);
 	m.createdAt = created ? reinterpret_cast<const char*>(created) : "";
-	sqlite3_finalize(stmt);
 	return m;
 }
 
 std::optional<User> Database::getUserById(int id, std::string& errMsg) {
 	const char* sql = "SELECT id, username, password_hash, phone, created_at FROM users WHERE id = ?;";
-	sqlite3_stmt* stmt = nullptr;
-	if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
-		errMsg = sqlite3_errmsg(db);
+	auto conn = reader();
+	StatementHandle stmt(conn.statements().acquire(sql, errMsg));
+	if (!stmt) {
 		return std::nullopt;
 	}
 	sqlite3_bind_int(stmt, 1, id);
 	if (sqlite3_step(stmt) != SQLITE_ROW) {
-		sqlite3_finalize(stmt);
 		return std::nullopt;
 	}
 	User u;
@@ -421,20 +686,18 @@ std::optional<User> Database::getUserById(int id, std::string& errMsg) {
 	u.phone = phone ? reinterpret_cast<const char*>(phone) : "";
 	const auto* created = sqlite3_column_text(stmt, 4);
 	u.createdAt = created ? reinterpret_cast<const char*>(created) : "";
-	sqlite3_finalize(stmt);
 	return u;
 }
 
 std::optional<Merchant> Database::getMerchantById(int id, std::string& errMsg) {
 	const char* sql = "SELECT id, username, password_hash, store_name, created_at FROM merchants WHERE id = ?;";
-	sqlite3_stmt* stmt = nullptr;
-	if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
-		errMsg = sqlite3_errmsg(db);
+	auto conn = reader();
+	StatementHandle stmt(conn.statements().acquire(sql, errMsg));
+	if (!stmt) {
 		return std::nullopt;
 	}
 	sqlite3_bind_int(stmt, 1, id);
 	if (sqlite3_step(stmt) != SQLITE_ROW) {
-		sqlite3_finalize(stmt);
 		return std::nullopt;
 	}
 	Merchant m;
@@ -445,15 +708,14 @@ std::optional<Merchant> Database::getMerchantById(int id, std::string& errMsg) {
 	m.storeName = store ? reinterpret_cast<const char*>(store) : "";
 	const auto* created = sqlite3_column_text(stmt, 4);
 	m.createdAt = created ? reinterpret_cast<const char*>(created) : "";
-	sqlite3_finalize(stmt);
 	return m;
 }
 
-bool Database::createSessionToken(const std::string& token, const std::optional<int>& userId, const std::optional<int>& merchantId, const std::string& expiresAt, std::string& errMsg) {
-	const char* sql = "INSERT INTO sessions(token, user_id, merchant_id, expires_at) VALUES(?,?,?,?);";
-	sqlite3_stmt* stmt = nullptr;
-	if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
-		errMsg = sqlite3_errmsg(db);
+bool Database::createSessionToken(const std::string& token, const std::optional<int>& userId, const std::optional<int>& merchantId, EpochMillis expiresAt, std::string& errMsg) {
+	const char* sql = "INSERT INTO sessions(token, user_id, merchant_id, expires_at, created_at) VALUES(?,?,?,?,?);";
+	auto conn = writer();
+	StatementHandle stmt(conn.statements().acquire(sql, errMsg));
+	if (!stmt) {
 		return false;
 	}
 	sqlite3_bind_text(stmt, 1, token.c_str(), -1, SQLITE_STATIC);
@@ -467,25 +729,25 @@ bool Database::createSessionToken(const std::string& token, const std::optional<
 	} else {
 		sqlite3_bind_null(stmt, 3);
 	}
-	sqlite3_bind_text(stmt, 4, expiresAt.c_str(), -1, SQLITE_STATIC);
+	sqlite3_bind_int64(stmt, 4, expiresAt);
+	sqlite3_bind_int64(stmt, 5, nowEpochMillis());
 	bool ok = sqlite3_step(stmt) == SQLITE_DONE;
 	if (!ok) {
-		errMsg = sqlite3_errmsg(db);
+		errMsg = sqlite3_errmsg(conn.db());
 	}
-	sqlite3_finalize(stmt);
 	return ok;
 }
 
 std::optional<Session> Database::getSessionByToken(const std::string& token, std::string& errMsg) {
-	const char* sql = "SELECT id, token, user_id, merchant_id, expires_at, created_at FROM sessions WHERE token = ? AND expires_at > CURRENT_TIMESTAMP;";
-	sqlite3_stmt* stmt = nullptr;
-	if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
-		errMsg = sqlite3_errmsg(db);
+	const char* sql = "SELECT id, token, user_id, merchant_id, expires_at, created_at FROM sessions WHERE token = ? AND expires_at > ?;";
+	auto conn = reader();
+	StatementHandle stmt(conn.statements().acquire(sql, errMsg));
+	if (!stmt) {
 		return std::nullopt;
 	}
 	sqlite3_bind_text(stmt, 1, token.c_str(), -1, SQLITE_STATIC);
+	sqlite3_bind_int64(stmt, 2, nowEpochMillis());
 	if (sqlite3_step(stmt) != SQLITE_ROW) {
-		sqlite3_finalize(stmt);
 		return std::nullopt;
 	}
 	Session s;
@@ -497,151 +759,478 @@ std::optional<Session> Database::getSessionByToken(const std::string& token, std
 	if (sqlite3_column_type(stmt, 3) != SQLITE_NULL) {
 		s.merchantId = sqlite3_column_int(stmt, 3);
 	}
-	s.expiresAt = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 4));
-	const auto* created = sqlite3_column_text(stmt, 5);
-	s.createdAt = created ? reinterpret_cast<const char*>(created) : "";
-	sqlite3_finalize(stmt);
+	s.expiresAt = sqlite3_column_int64(stmt, 4);
+	s.createdAt = sqlite3_column_int64(stmt, 5);
 	return s;
 }
 
+std::optional<int> Database::deleteExpiredSessions(int batchSize, std::string& errMsg) {
+	auto conn = writer();
+	StatementHandle stmt(conn.statements().acquire(kDeleteExpiredSessionsSql, errMsg));
+	if (!stmt) {
+		return std::nullopt;
+	}
+	sqlite3_bind_int64(stmt, 1, nowEpochMillis());
+	sqlite3_bind_int(stmt, 2, batchSize);
+	if (sqlite3_step(stmt) != SQLITE_DONE) {
+		errMsg = sqlite3_errmsg(conn.db());
+		return std::nullopt;
+	}
+	return sqlite3_changes(conn.db());
+}
+
 std::optional<int> Database::createOrder(const std::vector<OrderItem>& items, const std::optional<int>& userId, std::string& errMsg) {
 	if (items.empty()) {
 		errMsg = "Order items cannot be empty";
 		return std::nullopt;
 	}
-
-	char* em = nullptr;
-	if (sqlite3_exec(db, "BEGIN IMMEDIATE;", nullptr, nullptr, &em) != SQLITE_OK) {
-		if (em) { errMsg = em; sqlite3_free(em); }
+	// Priced before any write lock is taken, so a bad cart never waits for
+	// or holds the writer.
+	auto priced = dishTable.priceItems(items, errMsg);
+	if (!priced) {
 		return std::nullopt;
 	}
 
-	const char* insOrderSql = "INSERT INTO orders(user_id, status, total) VALUES(?, 'pending', 0);";
-	sqlite3_stmt* insOrderStmt = nullptr;
-	if (sqlite3_prepare_v2(db, insOrderSql, -1, &insOrderStmt, nullptr) != SQLITE_OK) {
-		errMsg = sqlite3_errmsg(db);
-		sqlite3_exec(db, "ROLLBACK;", nullptr, nullptr, nullptr);
-		return std::nullopt;
+	if (eventLog) {
+		return logOrderCreated(*priced, userId, errMsg);
+	}
+	if (groupCommit) {
+		OrderRequest request{*priced, userId, std::nullopt, ""};
+		groupCommit->submit(request);
+		if (!request.orderId) {
+			errMsg = request.errMsg;
+		}
+		return request.orderId;
 	}
-	if (userId) {
-		sqlite3_bind_int(insOrderStmt, 1, *userId);
-	} else {
-		sqlite3_bind_null(insOrderStmt, 1);
+
+	auto conn = writer();
+	if (!execCached(conn, "BEGIN IMMEDIATE;", errMsg)) {
+		return std::nullopt;
 	}
-	if (sqlite3_step(insOrderStmt) != SQLITE_DONE) {
-		errMsg = sqlite3_errmsg(db);
-		sqlite3_finalize(insOrderStmt);
-		sqlite3_exec(db, "ROLLBACK;", nullptr, nullptr, nullptr);
+	auto orderId = writeOrder(conn, std::nullopt, userId, *priced, nowEpochMillis(), errMsg);
+	if (!orderId || !execCached(conn, "COMMIT;", errMsg)) {
+		std::string ignored;
+		execCached(conn, "ROLLBACK;", ignored);
 		return std::nullopt;
 	}
-	sqlite3_finalize(insOrderStmt);
-	const int orderId = static_cast<int>(sqlite3_last_insert_rowid(db));
+	return orderId;
+}
 
-	sqlite3_stmt* priceStmt = nullptr;
-	const char* priceSql = "SELECT price FROM dishes WHERE id = ? AND is_available = 1;";
-	if (sqlite3_prepare_v2(db, priceSql, -1, &priceStmt, nullptr) != SQLITE_OK) {
-		errMsg = sqlite3_errmsg(db);
-		sqlite3_exec(db, "ROLLBACK;", nullptr, nullptr, nullptr);
-		return std::nullopt;
+void Database::enableGroupCommit(size_t maxBatch, int maxWaitMicros) {
+	groupCommit = std::make_unique<GroupCommitWriter>(
+		[this](std::vector<OrderRequest*>& batch) { commitOrderBatch(batch); },
+		maxBatch, std::chrono::microseconds(maxWaitMicros));
+}
+
+void Database::commitOrderBatch(std::vector<OrderRequest*>& batch) {
+	auto conn = writer();
+	std::string err;
+	if (!execCached(conn, "BEGIN IMMEDIATE;", err)) {
+		for (auto* request : batch) request->errMsg = err;
+		return;
+	}
+	// A savepoint per order keeps one bad cart from failing the whole batch.
+	for (auto* request : batch) {
+		execCached(conn, "SAVEPOINT batch_order;", err);
+		request->orderId = writeOrder(conn, std::nullopt, request->userId, request->items, nowEpochMillis(), request->errMsg);
+		if (!request->orderId) {
+			execCached(conn, "ROLLBACK TO batch_order;", err);
+		}
+		execCached(conn, "RELEASE batch_order;", err);
+	}
+	if (!execCached(conn, "COMMIT;", err)) {
+		std::string ignored;
+		execCached(conn, "ROLLBACK;", ignored);
+		for (auto* request : batch) {
+			request->orderId.reset();
+			request->errMsg = err;
+		}
 	}
+}
 
-	sqlite3_stmt* insItemStmt = nullptr;
-	const char* insItemSql = "INSERT INTO order_items(order_id, dish_id, quantity, unit_price) VALUES(?,?,?,?);";
-	if (sqlite3_prepare_v2(db, insItemSql, -1, &insItemStmt, nullptr) != SQLITE_OK) {
-		errMsg = sqlite3_errmsg(db);
-		sqlite3_finalize(priceStmt);
-		sqlite3_exec(db, "ROLLBACK;", nullptr, nullptr, nullptr);
-		return std::nullopt;
+bool Database::enableEventLog(const std::string& dir, size_t segmentBytes, std::string& errMsg) {
+	auto log = std::make_unique<OrderEventLog>();
+	if (!log->open(dir, segmentBytes, errMsg)) {
+		return false;
 	}
 
-	double total = 0.0;
-	for (const auto& item : items) {
-		sqlite3_bind_int(priceStmt, 1, item.dishId);
-		if (sqlite3_step(priceStmt) != SQLITE_ROW) {
-			errMsg = "Dish not available";
-			sqlite3_finalize(priceStmt);
-			sqlite3_finalize(insItemStmt);
-			sqlite3_exec(db, "ROLLBACK;", nullptr, nullptr, nullptr);
-			return std::nullopt;
+	uint64_t appliedLsn = 0;
+	{
+		auto conn = writer();
+		StatementHandle stmt(conn.statements().acquire("SELECT applied_lsn FROM event_log_state WHERE id = 1;", errMsg));
+		if (!stmt) {
+			return false;
 		}
-		const double unitPrice = sqlite3_column_double(priceStmt, 0);
-		sqlite3_reset(priceStmt);
-		sqlite3_clear_bindings(priceStmt);
-
-		sqlite3_bind_int(insItemStmt, 1, orderId);
-		sqlite3_bind_int(insItemStmt, 2, item.dishId);
-		sqlite3_bind_int(insItemStmt, 3, item.quantity);
-		sqlite3_bind_double(insItemStmt, 4, unitPrice);
-		if (sqlite3_step(insItemStmt) != SQLITE_DONE) {
-			errMsg = sqlite3_errmsg(db);
-			sqlite3_finalize(priceStmt);
-			sqlite3_finalize(insItemStmt);
-			sqlite3_exec(db, "ROLLBACK;", nullptr, nullptr, nullptr);
-			return std::nullopt;
+		if (sqlite3_step(stmt) == SQLITE_ROW) {
+			appliedLsn = static_cast<uint64_t>(sqlite3_column_int64(stmt, 0));
 		}
-		sqlite3_reset(insItemStmt);
-		sqlite3_clear_bindings(insItemStmt);
-		total += unitPrice * item.quantity;
 	}
-	sqlite3_finalize(priceStmt);
-	sqlite3_finalize(insItemStmt);
 
-	sqlite3_stmt* upd = nullptr;
-	const char* updSql = "UPDATE orders SET total = ?, updated_at = CURRENT_TIMESTAMP WHERE id = ?;";
-	if (sqlite3_prepare_v2(db, updSql, -1, &upd, nullptr) != SQLITE_OK) {
-		errMsg = sqlite3_errmsg(db);
-		sqlite3_exec(db, "ROLLBACK;", nullptr, nullptr, nullptr);
-		return std::nullopt;
+	// Bring the projection up to date before anything reads it.
+	std::vector<OrderEvent> batch;
+	size_t replayed = 0;
+	bool ok = true;
+	log->forEach(appliedLsn, [&](const OrderEvent& event) {
+		if (!ok) return;
+		batch.push_back(event);
+		if (batch.size() >= kEventApplyBatch) {
+			ok = applyEvents(batch, errMsg);
+			replayed += batch.size();
+			batch.clear();
+		}
+	});
+	if (ok && !batch.empty()) {
+		ok = applyEvents(batch, errMsg);
+		replayed += batch.size();
 	}
-	sqlite3_bind_double(upd, 1, total);
-	sqlite3_bind_int(upd, 2, orderId);
-	if (sqlite3_step(upd) != SQLITE_DONE) {
-		errMsg = sqlite3_errmsg(db);
-		sqlite3_finalize(upd);
-		sqlite3_exec(db, "ROLLBACK;", nullptr, nullptr, nullptr);
-		return std::nullopt;
+	if (!ok) {
+		errMsg = "order event replay failed: " + errMsg;
+		return false;
 	}
-	sqlite3_finalize(upd);
-
-	if (sqlite3_exec(db, "COMMIT;", nullptr, nullptr, &em) != SQLITE_OK) {
-		if (em) { errMsg = em; sqlite3_free(em); }
-		return std::nullopt;
+	if (replayed > 0) {
+		printf("Replayed %zu order events from %s\n", replayed, dir.c_str());
 	}
-	return orderId;
-}
+	log->advanceTo(appliedLsn);
+	log->releaseThrough(std::max(appliedLsn, log->lastLsn()));
 
-std::optional<Order> Database::getOrder(int orderId, std::string& errMsg) {
-	Order order{};
-	order.id = orderId;
+	// Ids are handed out here from now on, so SQLite never picks one itself.
+	{
+		auto conn = writer();
+		StatementHandle stmt(conn.statements().acquire("SELECT COALESCE(MAX(id), 0) FROM orders;", errMsg));
+		if (!stmt) {
+			return false;
+		}
+		if (sqlite3_step(stmt) == SQLITE_ROW) {
+			nextOrderId = sqlite3_column_int(stmt, 0) + 1;
+		}
+	}
 
-	// header
-	const char* selOrder = "SELECT status,total,user_id,pickup_notified,created_at,updated_at FROM orders WHERE id = ?;";
-	sqlite3_stmt* st = nullptr;
-	if (sqlite3_prepare_v2(db, selOrder, -1, &st, nullptr) != SQLITE_OK) {
-		errMsg = sqlite3_errmsg(db);
+	eventLog = std::move(log);
+	stopApplier = false;
+	eventApplier = std::thread([this]() { runEventApplier(); });
+	return true;
+}
+
+void Database::stopEventLog() {
+	if (!eventLog) return;
+	{
+		std::lock_guard<std::mutex> lock(eventMutex);
+		stopApplier = true;
+	}
+	eventsQueued.notify_all();
+	if (eventApplier.joinable()) {
+		eventApplier.join();
+	}
+	eventLog.reset();
+	unappliedOrders.clear();
+}
+
+std::optional<int> Database::logOrderCreated(const std::vector<OrderItem>& pricedItems, const std::optional<int>& userId, std::string& errMsg) {
+	Order order{};
+	order.userId = userId;
+	order.items = pricedItems;
+	order.status = "pending";
+	order.total = 0.0;
+	for (const auto& item : order.items) {
+		order.total += item.unitPrice * item.quantity;
+	}
+	order.pickupNotified = false;
+	order.createdAt = nowEpochMillis();
+	order.updatedAt = order.createdAt;
+
+	OrderEvent event{0, OrderEventType::Created, 0, order.createdAt, userId, pricedItems, ""};
+	{
+		std::lock_guard<std::mutex> lock(eventMutex);
+		event.orderId = nextOrderId;
+		if (!eventLog->append(event, errMsg)) {
+			return std::nullopt;
+		}
+		++nextOrderId;
+		order.id = event.orderId;
+		unappliedOrders[order.id] = {event.lsn, order};
+		unappliedEvents.push_back(event);
+	}
+	eventsQueued.notify_one();
+	if (!eventLog->waitDurable(event.lsn)) {
+		errMsg = "order event log sync failed";
 		return std::nullopt;
 	}
-	sqlite3_bind_int(st, 1, orderId);
-	if (sqlite3_step(st) != SQLITE_ROW) {
-		sqlite3_finalize(st);
+	return order.id;
+}
+
+std::optional<Order> Database::appendOrderChangeLocked(OrderEvent& event, std::string& errMsg) {
+	std::optional<Order> current;
+	const auto it = unappliedOrders.find(event.orderId);
+	if (it != unappliedOrders.end()) {
+		current = it->second.second;
+	} else {
+		// Archived orders are final; only live rows take changes.
+		current = readOrder(event.orderId, false, errMsg);
+	}
+	if (!current) {
+		return std::nullopt;
+	}
+	if (!eventLog->append(event, errMsg)) {
 		return std::nullopt;
 	}
-	order.status = reinterpret_cast<const char*>(sqlite3_column_text(st, 0));
-	order.total = sqlite3_column_double(st, 1);
-	if (sqlite3_column_type(st, 2) != SQLITE_NULL) {
-		order.userId = sqlite3_column_int(st, 2);
+	if (event.type == OrderEventType::StatusChanged) {
+		current->status = event.status;
+	} else {
+		current->pickupNotified = true;
+	}
+	current->updatedAt = event.at;
+	unappliedOrders[event.orderId] = {event.lsn, *current};
+	unappliedEvents.push_back(event);
+	return current;
+}
+
+bool Database::logOrderChange(int orderId, OrderEventType type, const std::string& status, std::string& errMsg) {
+	OrderEvent event{0, type, orderId, nowEpochMillis(), std::nullopt, {}, status};
+	{
+		// Held across read, append and overlay update so two changes to the
+		// same order are logged in the order their overlay states were built.
+		std::lock_guard<std::mutex> lock(eventMutex);
+		if (!appendOrderChangeLocked(event, errMsg)) {
+			// Unknown id: nothing to log, same as the direct write path.
+			return errMsg.empty();
+		}
+	}
+	eventsQueued.notify_one();
+	if (!eventLog->waitDurable(event.lsn)) {
+		errMsg = "order event log sync failed";
+		return false;
+	}
+	return true;
+}
+
+// Applies a run of events and records the last lsn in one transaction, so
+// every event reaches SQLite exactly once even across crashes.
+bool Database::applyEvents(const std::vector<OrderEvent>& events, std::string& errMsg) {
+	auto conn = writer();
+	if (!execCached(conn, "BEGIN IMMEDIATE;", errMsg)) {
+		return false;
+	}
+	auto fail = [&]() {
+		std::string ignored;
+		execCached(conn, "ROLLBACK;", ignored);
+		return false;
+	};
+	for (const auto& event : events) {
+		bool ok = true;
+		switch (event.type) {
+		case OrderEventType::Created:
+			ok = writeOrder(conn, event.orderId, event.userId, event.items, event.at, errMsg).has_value();
+			break;
+		case OrderEventType::StatusChanged:
+			ok = applyStatusChange(conn, event.orderId, event.status, event.at, errMsg);
+			break;
+		case OrderEventType::PickupNotified:
+			ok = applyPickupNotified(conn, event.orderId, event.at, errMsg);
+			break;
+		}
+		if (!ok) {
+			errMsg = "event " + std::to_string(event.lsn) + ": " + errMsg;
+			return fail();
+		}
+	}
+	{
+		StatementHandle stmt(conn.statements().acquire("UPDATE event_log_state SET applied_lsn = ? WHERE id = 1;", errMsg));
+		if (!stmt) {
+			return fail();
+		}
+		sqlite3_bind_int64(stmt, 1, static_cast<sqlite3_int64>(events.back().lsn));
+		if (sqlite3_step(stmt) != SQLITE_DONE) {
+			errMsg = sqlite3_errmsg(conn.db());
+			return fail();
+		}
+	}
+	if (!execCached(conn, "COMMIT;", errMsg)) {
+		return fail();
+	}
+	return true;
+}
+
+void Database::runEventApplier() {
+	while (true) {
+		std::vector<OrderEvent> batch;
+		{
+			std::unique_lock<std::mutex> lock(eventMutex);
+			eventsQueued.wait(lock, [&]() { return stopApplier || !unappliedEvents.empty(); });
+			if (unappliedEvents.empty()) {
+				return;
+			}
+			while (!unappliedEvents.empty() && batch.size() < kEventApplyBatch) {
+				batch.push_back(std::move(unappliedEvents.front()));
+				unappliedEvents.pop_front();
+			}
+		}
+		// Only durable events may reach SQLite; otherwise a crash could leave
+		// the projection ahead of the log.
+		const uint64_t last = batch.back().lsn;
+		if (!eventLog->waitDurable(last)) {
+			printf("Order event log sync failed; events after lsn %llu stay unapplied\n", static_cast<unsigned long long>(batch.front().lsn - 1));
+			return;
+		}
+		std::string err;
+		while (!applyEvents(batch, err)) {
+			printf("Applying order events failed: %s\n", err.c_str());
+			std::unique_lock<std::mutex> lock(eventMutex);
+			if (stopApplier) {
+				// Still in the log; the next start replays them.
+				return;
+			}
+			eventsQueued.wait_for(lock, std::chrono::seconds(1));
+			err.clear();
+		}
+		{
+			std::lock_guard<std::mutex> lock(eventMutex);
+			for (const auto& event : batch) {
+				const auto it = unappliedOrders.find(event.orderId);
+				if (it != unappliedOrders.end() && it->second.first <= last) {
+					unappliedOrders.erase(it);
+				}
+			}
+		}
+		eventLog->releaseThrough(last);
+	}
+}
+
+bool Database::loadDishTable(const ConnectionLease& conn, std::string& errMsg) {
+	StatementHandle stmt(conn.statements().acquire("SELECT id, price, is_available FROM dishes;", errMsg));
+	if (!stmt) {
+		return false;
+	}
+	std::vector<DishPrice> dishes;
+	int rc;
+	while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+		dishes.push_back(DishPrice{sqlite3_column_int(stmt, 0), sqlite3_column_double(stmt, 1), sqlite3_column_int(stmt, 2) != 0});
+	}
+	if (rc != SQLITE_DONE) {
+		errMsg = sqlite3_errmsg(conn.db());
+		return false;
+	}
+	dishTable.clear();
+	dishTable.set(dishes);
+	return true;
+}
+
+// Writes an order whose items already carry their unit prices, plus its
+// sales aggregates, inside the caller's transaction. Without an orderId
+// SQLite assigns the next one.
+std::optional<int> Database::writeOrder(const ConnectionLease& conn, const std::optional<int>& orderId, const std::optional<int>& userId,
+	const std::vector<OrderItem>& pricedItems, EpochMillis createdAt, std::string& errMsg) {
+	const EpochDay day = epochDayOf(createdAt);
+	double total = 0.0;
+	for (const auto& item : pricedItems) {
+		total += item.unitPrice * item.quantity;
+	}
+
+	int id = 0;
+	{
+		StatementHandle insOrderStmt(conn.statements().acquire("INSERT INTO orders(id, user_id, status, total, created_at, updated_at) VALUES(?, ?, 'pending', ?, ?, ?);", errMsg));
+		if (!insOrderStmt) {
+			return std::nullopt;
+		}
+		if (orderId) {
+			sqlite3_bind_int(insOrderStmt, 1, *orderId);
+		} else {
+			sqlite3_bind_null(insOrderStmt, 1);
+		}
+		if (userId) {
+			sqlite3_bind_int(insOrderStmt, 2, *userId);
+		} else {
+			sqlite3_bind_null(insOrderStmt, 2);
+		}
+		sqlite3_bind_double(insOrderStmt, 3, total);
+		sqlite3_bind_int64(insOrderStmt, 4, createdAt);
+		sqlite3_bind_int64(insOrderStmt, 5, createdAt);
+		if (sqlite3_step(insOrderStmt) != SQLITE_DONE) {
+			errMsg = sqlite3_errmsg(conn.db());
+			return std::nullopt;
+		}
+		id = static_cast<int>(sqlite3_last_insert_rowid(conn.db()));
+	}
+
+	StatementHandle insItemStmt(conn.statements().acquire("INSERT INTO order_items(order_id, dish_id, quantity, unit_price) VALUES(?,?,?,?);", errMsg));
+	StatementHandle dishSalesStmt(conn.statements().acquire(kAddDishSalesSql, errMsg));
+	if (!insItemStmt || !dishSalesStmt) {
+		return std::nullopt;
+	}
+	for (const auto& item : pricedItems) {
+		sqlite3_bind_int(insItemStmt, 1, id);
+		sqlite3_bind_int(insItemStmt, 2, item.dishId);
+		sqlite3_bind_int(insItemStmt, 3, item.quantity);
+		sqlite3_bind_double(insItemStmt, 4, item.unitPrice);
+		if (sqlite3_step(insItemStmt) != SQLITE_DONE) {
+			errMsg = sqlite3_errmsg(conn.db());
+			return std::nullopt;
+		}
+		sqlite3_reset(insItemStmt);
+		sqlite3_clear_bindings(insItemStmt);
+
+		sqlite3_bind_int64(dishSalesStmt, 1, day);
+		sqlite3_bind_int(dishSalesStmt, 2, item.dishId);
+		sqlite3_bind_int(dishSalesStmt, 3, item.quantity);
+		sqlite3_bind_double(dishSalesStmt, 4, item.unitPrice * item.quantity);
+		if (sqlite3_step(dishSalesStmt) != SQLITE_DONE) {
+			errMsg = sqlite3_errmsg(conn.db());
+			return std::nullopt;
+		}
+		sqlite3_reset(dishSalesStmt);
+		sqlite3_clear_bindings(dishSalesStmt);
+	}
+
+	if (!addDailySales(conn, day, 1, total, 0, 0.0, errMsg)) {
+		return std::nullopt;
+	}
+	return id;
+}
+
+std::optional<Order> Database::getOrder(int orderId, std::string& errMsg) {
+	if (eventLog) {
+		std::lock_guard<std::mutex> lock(eventMutex);
+		const auto it = unappliedOrders.find(orderId);
+		if (it != unappliedOrders.end()) {
+			return it->second.second;
+		}
+	}
+	return readOrder(orderId, true, errMsg);
+}
+
+std::optional<Order> Database::readOrder(int orderId, bool withArchive, std::string& errMsg) {
+	Order order{};
+	order.id = orderId;
+
+	auto conn = reader();
+	// Header and items (or the archive fallback) from one snapshot, so a
+	// concurrent archive move cannot leave a header without its items.
+	ReadTransaction snapshot(conn);
+	if (!snapshot.begin(errMsg)) {
+		return std::nullopt;
+	}
+	// header
+	{
+		StatementHandle st(conn.statements().acquire("SELECT status,total,user_id,pickup_notified,created_at,updated_at FROM orders WHERE id = ?;", errMsg));
+		if (!st) {
+			return std::nullopt;
+		}
+		sqlite3_bind_int(st, 1, orderId);
+		if (sqlite3_step(st) != SQLITE_ROW) {
+			return withArchive && archiveAttached ? getArchivedOrder(conn, orderId, errMsg) : std::nullopt;
+		}
+		order.status = reinterpret_cast<const char*>(sqlite3_column_text(st, 0));
+		order.total = sqlite3_column_double(st, 1);
+		if (sqlite3_column_type(st, 2) != SQLITE_NULL) {
+			order.userId = sqlite3_column_int(st, 2);
+		}
+		order.pickupNotified = sqlite3_column_int(st, 3) != 0;
+		order.createdAt = sqlite3_column_int64(st, 4);
+		order.updatedAt = sqlite3_column_int64(st, 5);
 	}
-	order.pickupNotified = sqlite3_column_int(st, 3) != 0;
-	const auto* created = sqlite3_column_text(st, 4);
-	order.createdAt = created ? reinterpret_cast<const char*>(created) : "";
-	const auto* updated = sqlite3_column_text(st, 5);
-	order.updatedAt = updated ? reinterpret_cast<const char*>(updated) : "";
-	sqlite3_finalize(st);
 
 	// items
-	const char* selItems = "SELECT dish_id, quantity, unit_price FROM order_items WHERE order_id = ? ORDER BY id;";
-	if (sqlite3_prepare_v2(db, selItems, -1, &st, nullptr) != SQLITE_OK) {
-		errMsg = sqlite3_errmsg(db);
+	StatementHandle st(conn.statements().acquire(kOrderItemsSql, errMsg));
+	if (!st) {
 		return std::nullopt;
 	}
 	sqlite3_bind_int(st, 1, orderId);
@@ -652,128 +1241,581 @@ std::optional<Order> Database::getOrder(int orderId, std::string& errMsg) {
 		it.unitPrice = sqlite3_column_double(st, 2);
 		order.items.push_back(it);
 	}
-	sqlite3_finalize(st);
 	return order;
 }
 
-std::vector<Order> Database::getAllOrders(std::string& errMsg) {
-	std::vector<Order> result;
-	const char* sql = "SELECT id, status, total, user_id, pickup_notified, created_at, updated_at FROM orders ORDER BY id DESC;";
-	sqlite3_stmt* stmt = nullptr;
-	if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
-		errMsg = sqlite3_errmsg(db);
-		return result;
+std::optional<Order> Database::getArchivedOrder(const ConnectionLease& conn, int orderId, std::string& errMsg) {
+	const char* sql =
+		"SELECT o.id, o.status, o.total, o.user_id, o.pickup_notified, o.created_at, o.updated_at, "
+		"i.dish_id, i.quantity, i.unit_price "
+		"FROM archive.orders o LEFT JOIN archive.order_items i ON i.order_id = o.id "
+		"WHERE o.id = ? ORDER BY i.id;";
+	StatementHandle stmt(conn.statements().acquire(sql, errMsg));
+	if (!stmt) {
+		return std::nullopt;
 	}
+	sqlite3_bind_int(stmt, 1, orderId);
+	auto orders = readOrdersWithItems(stmt);
+	if (orders.empty()) {
+		return std::nullopt;
+	}
+	orders.front().archived = true;
+	return std::move(orders.front());
+}
 
-	while (sqlite3_step(stmt) == SQLITE_ROW) {
-		Order order;
-		order.id = sqlite3_column_int(stmt, 0);
-		order.status = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
-		order.total = sqlite3_column_double(stmt, 2);
-		if (sqlite3_column_type(stmt, 3) != SQLITE_NULL) {
-			order.userId = sqlite3_column_int(stmt, 3);
-		}
-		order.pickupNotified = sqlite3_column_int(stmt, 4) != 0;
-		const auto* created = sqlite3_column_text(stmt, 5);
-		order.createdAt = created ? reinterpret_cast<const char*>(created) : "";
-		const auto* updated = sqlite3_column_text(stmt, 6);
-		order.updatedAt = updated ? reinterpret_cast<const char*>(updated) : "";
-
-		const char* selItems = "SELECT dish_id, quantity, unit_price FROM order_items WHERE order_id = ? ORDER BY id;";
-		sqlite3_stmt* itemStmt = nullptr;
-		if (sqlite3_prepare_v2(db, selItems, -1, &itemStmt, nullptr) == SQLITE_OK) {
-			sqlite3_bind_int(itemStmt, 1, order.id);
-			while (sqlite3_step(itemStmt) == SQLITE_ROW) {
-				OrderItem it;
-				it.dishId = sqlite3_column_int(itemStmt, 0);
-				it.quantity = sqlite3_column_int(itemStmt, 1);
-				it.unitPrice = sqlite3_column_double(itemStmt, 2);
-				order.items.push_back(it);
-			}
-			sqlite3_finalize(itemStmt);
+std::vector<Order> Database::queryOrders(const char* sql, const std::function<void(sqlite3_stmt*)>& bind, bool includeArchived, int limit, std::string& errMsg) {
+	auto conn = reader();
+	// The live and archive halves must come from one snapshot, or an order
+	// archived in between shows up twice or not at all.
+	ReadTransaction snapshot(conn);
+	if (includeArchived && archiveAttached && !snapshot.begin(errMsg)) {
+		return {};
+	}
+	std::vector<Order> live;
+	{
+		StatementHandle stmt(conn.statements().acquire(sql, errMsg));
+		if (!stmt) {
+			return {};
 		}
+		bind(stmt);
+		live = readOrdersWithItems(stmt);
+	}
+	if (!includeArchived || !archiveAttached) {
+		return live;
+	}
+	StatementHandle stmt(conn.statements().acquire(archiveSql(sql), errMsg));
+	if (!stmt) {
+		return {};
+	}
+	bind(stmt);
+	auto archived = readOrdersWithItems(stmt);
+	for (auto& order : archived) {
+		order.archived = true;
+	}
+	return mergeNewestFirst(std::move(live), std::move(archived), limit);
+}
+
+std::vector<Order> Database::getAllOrders(std::string& errMsg, bool includeArchived) {
+	const char* sql =
+		"SELECT o.id, o.status, o.total, o.user_id, o.pickup_notified, o.created_at, o.updated_at, "
+		"i.dish_id, i.quantity, i.unit_price "
+		"FROM orders o LEFT JOIN order_items i ON i.order_id = o.id "
+		"ORDER BY o.id DESC, i.id;";
+	return queryOrders(sql, [](sqlite3_stmt*) {}, includeArchived, 0, errMsg);
+}
 
-		result.push_back(std::move(order));
+std::vector<Order> Database::getOrdersByUser(int userId, std::string& errMsg, bool includeArchived) {
+	return queryOrders(kOrdersByUserSql, [&](sqlite3_stmt* stmt) {
+		sqlite3_bind_int(stmt, 1, userId);
+	}, includeArchived, 0, errMsg);
+}
+
+std::vector<Order> Database::getActiveOrders(std::string& errMsg) {
+	auto conn = reader();
+	StatementHandle stmt(conn.statements().acquire(kActiveOrdersSql, errMsg));
+	if (!stmt) {
+		return {};
 	}
-	sqlite3_finalize(stmt);
-	return result;
+	return readOrdersWithItems(stmt);
 }
 
-std::vector<Order> Database::getOrdersByUser(int userId, std::string& errMsg) {
-	std::vector<Order> result;
-	const char* sql = "SELECT id, status, total, user_id, pickup_notified, created_at, updated_at FROM orders WHERE user_id = ? ORDER BY id DESC;";
-	sqlite3_stmt* stmt = nullptr;
-	if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
-		errMsg = sqlite3_errmsg(db);
-		return result;
+std::vector<Order> Database::getAllOrdersPage(const std::optional<int>& beforeId, int limit, std::string& errMsg, bool includeArchived) {
+	return queryOrders(kOrdersPageSql, [&](sqlite3_stmt* stmt) {
+		sqlite3_bind_int64(stmt, 1, beforeId ? *beforeId : INT64_MAX);
+		sqlite3_bind_int(stmt, 2, limit);
+	}, includeArchived, limit, errMsg);
+}
+
+std::vector<Order> Database::getOrdersByUserPage(int userId, const std::optional<int>& beforeId, int limit, std::string& errMsg, bool includeArchived) {
+	return queryOrders(kOrdersByUserPageSql, [&](sqlite3_stmt* stmt) {
+		sqlite3_bind_int(stmt, 1, userId);
+		sqlite3_bind_int64(stmt, 2, beforeId ? *beforeId : INT64_MAX);
+		sqlite3_bind_int(stmt, 3, limit);
+	}, includeArchived, limit, errMsg);
+}
+
+bool Database::addDailySales(const ConnectionLease& conn, EpochDay day, int orders, double revenue, int completed, double completedRevenue, std::string& errMsg) {
+	StatementHandle stmt(conn.statements().acquire(
+		"INSERT INTO daily_sales(day, order_count, revenue, completed_count, completed_revenue) VALUES(?,?,?,?,?) "
+		"ON CONFLICT(day) DO UPDATE SET order_count = order_count + excluded.order_count, "
+		"revenue = revenue + excluded.revenue, completed_count = completed_count + excluded.completed_count, "
+		"completed_revenue = completed_revenue + excluded.completed_revenue;", errMsg));
+	if (!stmt) {
+		return false;
 	}
-	sqlite3_bind_int(stmt, 1, userId);
+	sqlite3_bind_int64(stmt, 1, day);
+	sqlite3_bind_int(stmt, 2, orders);
+	sqlite3_bind_double(stmt, 3, revenue);
+	sqlite3_bind_int(stmt, 4, completed);
+	sqlite3_bind_double(stmt, 5, completedRevenue);
+	if (sqlite3_step(stmt) != SQLITE_DONE) {
+		errMsg = sqlite3_errmsg(conn.db());
+		return false;
+	}
+	return true;
+}
 
-	while (sqlite3_step(stmt) == SQLITE_ROW) {
-		Order order;
-		order.id = sqlite3_column_int(stmt, 0);
-		order.status = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
-		order.total = sqlite3_column_double(stmt, 2);
-		order.userId = sqlite3_column_int(stmt, 3);
-		order.pickupNotified = sqlite3_column_int(stmt, 4) != 0;
-		const auto* created = sqlite3_column_text(stmt, 5);
-		order.createdAt = created ? reinterpret_cast<const char*>(created) : "";
-		const auto* updated = sqlite3_column_text(stmt, 6);
-		order.updatedAt = updated ? reinterpret_cast<const char*>(updated) : "";
-
-		const char* selItems = "SELECT dish_id, quantity, unit_price FROM order_items WHERE order_id = ? ORDER BY id;";
-		sqlite3_stmt* itemStmt = nullptr;
-		if (sqlite3_prepare_v2(db, selItems, -1, &itemStmt, nullptr) == SQLITE_OK) {
-			sqlite3_bind_int(itemStmt, 1, order.id);
-			while (sqlite3_step(itemStmt) == SQLITE_ROW) {
-				OrderItem it;
-				it.dishId = sqlite3_column_int(itemStmt, 0);
-				it.quantity = sqlite3_column_int(itemStmt, 1);
-				it.unitPrice = sqlite3_column_double(itemStmt, 2);
-				order.items.push_back(it);
+bool Database::updateOrderStatus(int orderId, const std::string& status, std::string& errMsg) {
+	if (eventLog) {
+		return logOrderChange(orderId, OrderEventType::StatusChanged, status, errMsg);
+	}
+	auto conn = writer();
+	if (!execCached(conn, "BEGIN IMMEDIATE;", errMsg)) {
+		return false;
+	}
+	if (!applyStatusChange(conn, orderId, status, nowEpochMillis(), errMsg) || !execCached(conn, "COMMIT;", errMsg)) {
+		std::string ignored;
+		execCached(conn, "ROLLBACK;", ignored);
+		return false;
+	}
+	return true;
+}
+
+std::optional<std::vector<std::optional<Order>>> Database::updateOrderStatuses(const std::vector<OrderStatusUpdate>& updates, std::string& errMsg) {
+	std::vector<std::optional<Order>> results;
+	results.reserve(updates.size());
+	const EpochMillis now = nowEpochMillis();
+	if (eventLog) {
+		uint64_t lastLsn = 0;
+		{
+			std::lock_guard<std::mutex> lock(eventMutex);
+			for (const auto& update : updates) {
+				OrderEvent event{0, OrderEventType::StatusChanged, update.orderId, now, std::nullopt, {}, update.status};
+				auto order = appendOrderChangeLocked(event, errMsg);
+				if (!order && !errMsg.empty()) {
+					// Changes appended so far stay logged and will be applied.
+					return std::nullopt;
+				}
+				if (order) {
+					lastLsn = event.lsn;
+				}
+				results.push_back(std::move(order));
 			}
-			sqlite3_finalize(itemStmt);
 		}
-		result.push_back(std::move(order));
+		if (lastLsn > 0) {
+			eventsQueued.notify_one();
+			if (!eventLog->waitDurable(lastLsn)) {
+				errMsg = "order event log sync failed";
+				return std::nullopt;
+			}
+		}
+		if (!fillArchivedResults(reader(), updates, results, errMsg)) {
+			return std::nullopt;
+		}
+		return results;
 	}
-	sqlite3_finalize(stmt);
-	return result;
+
+	auto conn = writer();
+	if (!execCached(conn, "BEGIN IMMEDIATE;", errMsg)) {
+		return std::nullopt;
+	}
+	auto fail = [&]() -> std::optional<std::vector<std::optional<Order>>> {
+		std::string ignored;
+		execCached(conn, "ROLLBACK;", ignored);
+		return std::nullopt;
+	};
+	std::string ids = "[";
+	for (const auto& update : updates) {
+		if (!applyStatusChange(conn, update.orderId, update.status, now, errMsg)) {
+			return fail();
+		}
+		ids += (ids.size() > 1 ? "," : "") + std::to_string(update.orderId);
+	}
+	ids += "]";
+	// Read the results back inside the transaction with one query instead of
+	// a getOrder per id.
+	std::unordered_map<int, Order> updated;
+	{
+		const char* sql =
+			"SELECT o.id, o.status, o.total, o.user_id, o.pickup_notified, o.created_at, o.updated_at, "
+			"i.dish_id, i.quantity, i.unit_price "
+			"FROM orders o LEFT JOIN order_items i ON i.order_id = o.id "
+			"WHERE o.id IN (SELECT value FROM json_each(?)) "
+			"ORDER BY o.id DESC, i.id;";
+		StatementHandle stmt(conn.statements().acquire(sql, errMsg));
+		if (!stmt) {
+			return fail();
+		}
+		sqlite3_bind_text(stmt, 1, ids.c_str(), -1, SQLITE_STATIC);
+		for (auto& order : readOrdersWithItems(stmt)) {
+			const int id = order.id;
+			updated.emplace(id, std::move(order));
+		}
+	}
+	for (const auto& update : updates) {
+		const auto it = updated.find(update.orderId);
+		results.push_back(it == updated.end() ? std::nullopt : std::optional<Order>(it->second));
+	}
+	if (!fillArchivedResults(conn, updates, results, errMsg) || !execCached(conn, "COMMIT;", errMsg)) {
+		return fail();
+	}
+	return results;
 }
 
-bool Database::updateOrderStatus(int orderId, const std::string& status, std::string& errMsg) {
-	const char* sql = "UPDATE orders SET status = ?, updated_at = CURRENT_TIMESTAMP WHERE id = ?;";
-	sqlite3_stmt* stmt = nullptr;
-	if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
-		errMsg = sqlite3_errmsg(db);
+// Batch results for ids with no live row: the archived order, unchanged, so
+// callers can tell "archived" from "unknown".
+bool Database::fillArchivedResults(const ConnectionLease& conn, const std::vector<OrderStatusUpdate>& updates,
+	std::vector<std::optional<Order>>& results, std::string& errMsg) {
+	if (!archiveAttached) {
+		return true;
+	}
+	for (size_t i = 0; i < updates.size(); ++i) {
+		if (!results[i]) {
+			results[i] = getArchivedOrder(conn, updates[i].orderId, errMsg);
+			if (!errMsg.empty()) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+// Inside the caller's transaction. Moves the order's total in or out of the
+// completed sales aggregate when the status crosses "completed". An unknown
+// id is not an error; the caller reports the 404.
+bool Database::applyStatusChange(const ConnectionLease& conn, int orderId, const std::string& status, EpochMillis at, std::string& errMsg) {
+	std::string previous;
+	double total = 0.0;
+	EpochMillis createdAt = 0;
+	{
+		StatementHandle st(conn.statements().acquire("SELECT status, total, created_at FROM orders WHERE id = ?;", errMsg));
+		if (!st) {
+			return false;
+		}
+		sqlite3_bind_int(st, 1, orderId);
+		if (sqlite3_step(st) != SQLITE_ROW) {
+			return true;
+		}
+		previous = reinterpret_cast<const char*>(sqlite3_column_text(st, 0));
+		total = sqlite3_column_double(st, 1);
+		createdAt = sqlite3_column_int64(st, 2);
+	}
+
+	{
+		StatementHandle stmt(conn.statements().acquire("UPDATE orders SET status = ?, updated_at = ? WHERE id = ?;", errMsg));
+		if (!stmt) {
+			return false;
+		}
+		sqlite3_bind_text(stmt, 1, status.c_str(), -1, SQLITE_STATIC);
+		sqlite3_bind_int64(stmt, 2, at);
+		sqlite3_bind_int(stmt, 3, orderId);
+		if (sqlite3_step(stmt) != SQLITE_DONE) {
+			errMsg = sqlite3_errmsg(conn.db());
+			return false;
+		}
+	}
+
+	const int completedDelta = (status == "completed") - (previous == "completed");
+	return completedDelta == 0 ||
+		addDailySales(conn, epochDayOf(createdAt), 0, 0.0, completedDelta, completedDelta * total, errMsg);
+}
+
+bool Database::markOrderPickupNotified(int orderId, std::string& errMsg) {
+	if (eventLog) {
+		return logOrderChange(orderId, OrderEventType::PickupNotified, "", errMsg);
+	}
+	auto conn = writer();
+	return applyPickupNotified(conn, orderId, nowEpochMillis(), errMsg);
+}
+
+bool Database::applyPickupNotified(const ConnectionLease& conn, int orderId, EpochMillis at, std::string& errMsg) {
+	const char* sql = "UPDATE orders SET pickup_notified = 1, updated_at = ? WHERE id = ?;";
+	StatementHandle stmt(conn.statements().acquire(sql, errMsg));
+	if (!stmt) {
 		return false;
 	}
-	sqlite3_bind_text(stmt, 1, status.c_str(), -1, SQLITE_STATIC);
+	sqlite3_bind_int64(stmt, 1, at);
 	sqlite3_bind_int(stmt, 2, orderId);
-	
 	if (sqlite3_step(stmt) != SQLITE_DONE) {
-		errMsg = sqlite3_errmsg(db);
-		sqlite3_finalize(stmt);
+		errMsg = sqlite3_errmsg(conn.db());
 		return false;
 	}
-	sqlite3_finalize(stmt);
 	return true;
 }
 
-bool Database::markOrderPickupNotified(int orderId, std::string& errMsg) {
-	const char* sql = "UPDATE orders SET pickup_notified = 1, updated_at = CURRENT_TIMESTAMP WHERE id = ?;";
-	sqlite3_stmt* stmt = nullptr;
-	if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
-		errMsg = sqlite3_errmsg(db);
-		return false;
+SalesReport Database::getSalesReport(EpochDay fromDay, EpochDay toDay, std::string& errMsg) {
+	SalesReport report;
+	auto conn = reader();
+	ReadTransaction snapshot(conn);
+	if (!snapshot.begin(errMsg)) {
+		return report;
+	}
+	report.days = readDailySales(conn, fromDay, toDay, errMsg);
+	if (!errMsg.empty()) {
+		return report;
+	}
+	report.dishes = readDishSales(conn, fromDay, toDay, errMsg);
+	return report;
+}
+
+std::vector<DailySales> Database::readDailySales(const ConnectionLease& conn, EpochDay fromDay, EpochDay toDay, std::string& errMsg) {
+	std::vector<DailySales> result;
+	StatementHandle stmt(conn.statements().acquire(
+		"SELECT day, order_count, revenue, completed_count, completed_revenue FROM daily_sales "
+		"WHERE day BETWEEN ? AND ? ORDER BY day;", errMsg));
+	if (!stmt) {
+		return result;
 	}
-	sqlite3_bind_int(stmt, 1, orderId);
-	if (sqlite3_step(stmt) != SQLITE_DONE) {
-		errMsg = sqlite3_errmsg(db);
+	sqlite3_bind_int64(stmt, 1, fromDay);
+	sqlite3_bind_int64(stmt, 2, toDay);
+	while (sqlite3_step(stmt) == SQLITE_ROW) {
+		DailySales row{};
+		row.day = sqlite3_column_int64(stmt, 0);
+		row.orderCount = sqlite3_column_int(stmt, 1);
+		row.revenue = sqlite3_column_double(stmt, 2);
+		row.completedCount = sqlite3_column_int(stmt, 3);
+		row.completedRevenue = sqlite3_column_double(stmt, 4);
+		result.push_back(row);
+	}
+	return result;
+}
+
+std::vector<DishSales> Database::readDishSales(const ConnectionLease& conn, EpochDay fromDay, EpochDay toDay, std::string& errMsg) {
+	std::vector<DishSales> result;
+	StatementHandle stmt(conn.statements().acquire(
+		"SELECT s.dish_id, d.name, SUM(s.quantity), SUM(s.revenue) FROM dish_sales s "
+		"LEFT JOIN dishes d ON d.id = s.dish_id "
+		"WHERE s.day BETWEEN ? AND ? GROUP BY s.dish_id ORDER BY 4 DESC, s.dish_id;", errMsg));
+	if (!stmt) {
+		return result;
+	}
+	sqlite3_bind_int64(stmt, 1, fromDay);
+	sqlite3_bind_int64(stmt, 2, toDay);
+	while (sqlite3_step(stmt) == SQLITE_ROW) {
+		DishSales row{};
+		row.dishId = sqlite3_column_int(stmt, 0);
+		const auto* name = sqlite3_column_text(stmt, 1);
+		row.name = name ? reinterpret_cast<const char*>(name) : "";
+		row.quantity = sqlite3_column_int(stmt, 2);
+		row.revenue = sqlite3_column_double(stmt, 3);
+		result.push_back(std::move(row));
+	}
+	return result;
+}
+
+bool Database::attachArchive(const std::string& path, std::string& errMsg) {
+	auto attach = [&](sqlite3* db) {
+		sqlite3_stmt* stmt = nullptr;
+		if (sqlite3_prepare_v2(db, "ATTACH DATABASE ? AS archive;", -1, &stmt, nullptr) != SQLITE_OK) {
+			errMsg = sqlite3_errmsg(db);
+			return false;
+		}
+		sqlite3_bind_text(stmt, 1, path.c_str(), -1, SQLITE_TRANSIENT);
+		const bool ok = sqlite3_step(stmt) == SQLITE_DONE;
+		if (!ok) {
+			errMsg = sqlite3_errmsg(db);
+		}
 		sqlite3_finalize(stmt);
+		return ok;
+	};
+
+	{
+		auto conn = writer();
+		if (archiveAttached) return true;
+		if (!attach(conn.db())) {
+			return false;
+		}
+		char* em = nullptr;
+		// Match the main file so readers never block on the archive either.
+		const char* journal = readers.empty() ? "" : "PRAGMA archive.journal_mode = WAL;";
+		const std::string script = std::string(journal) + kArchiveSchema;
+		if (sqlite3_exec(conn.db(), script.c_str(), nullptr, nullptr, &em) != SQLITE_OK) {
+			errMsg = em ? em : sqlite3_errmsg(conn.db());
+			if (em) sqlite3_free(em);
+			return false;
+		}
+	}
+	for (auto& reader : readers) {
+		std::lock_guard<std::recursive_mutex> lock(reader->mutex);
+		if (!attach(reader->db)) {
+			return false;
+		}
+	}
+	archiveAttached = true;
+	return true;
+}
+
+std::optional<int> Database::archiveCompletedOrders(int olderThanDays, int batchSize, std::string& errMsg) {
+	if (!archiveAttached) {
+		errMsg = "archive database is not attached";
+		return std::nullopt;
+	}
+	const EpochMillis cutoff = nowEpochMillis() - static_cast<EpochMillis>(olderThanDays) * 24 * 60 * 60 * 1000;
+	// Column lists are spelled out so the copy does not depend on table layout.
+	const char* copySteps[] = {
+		"INSERT OR REPLACE INTO archive.orders(id, user_id, status, total, pickup_notified, created_at, updated_at) "
+		"SELECT id, user_id, status, total, pickup_notified, created_at, updated_at FROM main.orders "
+		"WHERE id IN (SELECT id FROM temp.archive_batch);",
+		"DELETE FROM archive.order_items WHERE order_id IN (SELECT id FROM temp.archive_batch);",
+		"INSERT INTO archive.order_items(id, order_id, dish_id, quantity, unit_price) "
+		"SELECT id, order_id, dish_id, quantity, unit_price FROM main.order_items "
+		"WHERE order_id IN (SELECT id FROM temp.archive_batch);",
+	};
+	const char* deleteSteps[] = {
+		"DELETE FROM main.order_items WHERE order_id IN (SELECT id FROM temp.archive_batch);",
+		"DELETE FROM main.orders WHERE id IN (SELECT id FROM temp.archive_batch);",
+	};
+
+	int moved = 0;
+	while (true) {
+		// One short transaction per batch so order writes are never held up long.
+		auto conn = writer();
+		if (!execCached(conn, "BEGIN IMMEDIATE;", errMsg)) {
+			return std::nullopt;
+		}
+		auto fail = [&]() -> std::optional<int> {
+			std::string ignored;
+			execCached(conn, "ROLLBACK;", ignored);
+			return std::nullopt;
+		};
+		if (!execCached(conn, "DELETE FROM temp.archive_batch;", errMsg)) {
+			return fail();
+		}
+		{
+			// The newest order always stays live: new ids are MAX(id) + 1 of the
+			// live table, so archiving it could hand its id out again.
+			StatementHandle pick(conn.statements().acquire(
+				"INSERT INTO temp.archive_batch(id) SELECT id FROM main.orders "
+				"WHERE status = 'completed' AND pickup_notified = 1 AND updated_at < ? "
+				"AND id < (SELECT MAX(id) FROM main.orders) "
+				"ORDER BY id LIMIT ?;", errMsg));
+			if (!pick) {
+				return fail();
+			}
+			sqlite3_bind_int64(pick, 1, cutoff);
+			sqlite3_bind_int(pick, 2, batchSize);
+			if (sqlite3_step(pick) != SQLITE_DONE) {
+				errMsg = sqlite3_errmsg(conn.db());
+				return fail();
+			}
+		}
+		const int batch = sqlite3_changes(conn.db());
+		if (batch == 0) {
+			execCached(conn, "COMMIT;", errMsg);
+			return moved;
+		}
+		for (const char* step : copySteps) {
+			if (!execCached(conn, step, errMsg)) {
+				return fail();
+			}
+		}
+		// In WAL mode a commit spanning attached files is not atomic across
+		// them, and main commits first, so a reader could briefly find the
+		// batch in neither file. Committing the copy before the delete means
+		// it is briefly in both instead, which readers resolve in favour of
+		// main. The copy is idempotent if the delete never happens.
+		if (!execCached(conn, "COMMIT;", errMsg) || !execCached(conn, "BEGIN IMMEDIATE;", errMsg)) {
+			return fail();
+		}
+		for (const char* step : deleteSteps) {
+			if (!execCached(conn, step, errMsg)) {
+				return fail();
+			}
+		}
+		if (!execCached(conn, "COMMIT;", errMsg)) {
+			return fail();
+		}
+		moved += batch;
+		if (batch < batchSize) {
+			return moved;
+		}
+	}
+}
+
+bool Database::backupTo(const std::string& schema, const std::string& destPath, int pagesPerStep, std::chrono::milliseconds pause,
+	const std::function<void(int, int)>& onProgress, std::string& errMsg) {
+	if (!writerConn.db) {
+		errMsg = "database is not open";
+		return false;
+	}
+	const std::string partialPath = destPath + ".partial";
+	std::remove(partialPath.c_str());
+	sqlite3* dest = nullptr;
+	if (sqlite3_open_v2(partialPath.c_str(), &dest, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE | SQLITE_OPEN_NOMUTEX, nullptr) != SQLITE_OK) {
+		errMsg = sqlite3_errmsg(dest);
+		sqlite3_close(dest);
+		return false;
+	}
+
+	sqlite3_backup* backup = nullptr;
+	{
+		auto conn = writer();
+		backup = sqlite3_backup_init(dest, "main", conn.db(), schema.c_str());
+	}
+	if (!backup) {
+		errMsg = sqlite3_errmsg(dest);
+		sqlite3_close(dest);
+		std::remove(partialPath.c_str());
+		return false;
+	}
+
+	int rc = SQLITE_OK;
+	while (true) {
+		int remaining = 0;
+		int total = 0;
+		{
+			auto conn = writer();
+			rc = sqlite3_backup_step(backup, pagesPerStep);
+			remaining = sqlite3_backup_remaining(backup);
+			total = sqlite3_backup_pagecount(backup);
+		}
+		if (onProgress) {
+			onProgress(remaining, total);
+		}
+		if (rc != SQLITE_OK && rc != SQLITE_BUSY && rc != SQLITE_LOCKED) {
+			break;
+		}
+		std::this_thread::sleep_for(pause);
+	}
+	{
+		auto conn = writer();
+		sqlite3_backup_finish(backup);
+	}
+	if (rc != SQLITE_DONE) {
+		errMsg = std::string("backup failed: ") + sqlite3_errstr(rc);
+		sqlite3_close(dest);
+		std::remove(partialPath.c_str());
+		return false;
+	}
+	sqlite3_close(dest);
+
+#ifdef _WIN32
+	// std::rename does not replace an existing file on Windows.
+	std::remove(destPath.c_str());
+#endif
+	if (std::rename(partialPath.c_str(), destPath.c_str()) != 0) {
+		errMsg = "could not move " + partialPath + " to " + destPath;
 		return false;
 	}
-	sqlite3_finalize(stmt);
 	return true;
 }
 
+StatementCacheStats Database::statementCacheStats() {
+	StatementCacheStats total{0, 0, 0};
+	auto add = [&](const StatementCacheStats& part) {
+		total.hits += part.hits;
+		total.misses += part.misses;
+		total.size += part.size;
+	};
+	{
+		auto conn = writer();
+		add(conn.statements().stats());
+	}
+	for (auto& reader : readers) {
+		std::lock_guard<std::recursive_mutex> lock(reader->mutex);
+		add(reader->statements.stats());
+	}
+	return total;
+}
 
+bool Database::execCached(const ConnectionLease& conn, const char* sql, std::string& errMsg) {
+	StatementHandle stmt(conn.statements().acquire(sql, errMsg));
+	if (!stmt) {
+		return false;
+	}
+	if (sqlite3_step(stmt) != SQLITE_DONE) {
+		errMsg = sqlite3_errmsg(conn.db());
+		return false;
+	}
+	return true;
+}
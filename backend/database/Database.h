@@ -2,61 +2,202 @@
 #include <string>
 #include <vector>
 #include <optional>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <utility>
 #include <sqlite3.h>
-#include "../models/Dish.h"
-#include "../models/Order.h"
-#include "../models/User.h"
-#include "../models/Merchant.h"
-#include "../models/Session.h"
+#include "DishTable.h"
+#include "GroupCommitWriter.h"
+#include "OrderEventLog.h"
+#include "StatementCache.h"
+#include "Storage.h"
 
-class Database {
+// One SQLite handle and its prepared statements. Used by one thread at a time.
+struct DbConnection {
+	sqlite3* db{nullptr};
+	std::recursive_mutex mutex;
+	StatementCache statements;
+};
+
+// Exclusive use of a DbConnection for the lifetime of the lease.
+class ConnectionLease {
+public:
+	ConnectionLease(DbConnection& conn, std::unique_lock<std::recursive_mutex> lock)
+		: conn(&conn), lock(std::move(lock)) {}
+
+	sqlite3* db() const { return conn->db; }
+	StatementCache& statements() const { return conn->statements; }
+
+private:
+	DbConnection* conn;
+	std::unique_lock<std::recursive_mutex> lock;
+};
+
+class Database : public Storage {
 public:
 	static Database& instance();
 
-	bool open(const std::string& path, std::string& errMsg);
+	// With readerConnections > 0 the database is switched to WAL mode and
+	// read-only queries are spread over that many extra connections, so they
+	// no longer queue behind the single writer.
+	bool open(const std::string& path, std::string& errMsg, int readerConnections = 0);
 	void close();
+	// Applies pending migrations; a no-op when user_version is current.
 	bool initializeSchema(std::string& errMsg);
-	bool hasInitialData();
-	bool insertInitialData(std::string& errMsg);
 
-	std::vector<Dish> getAllDishes(std::string& errMsg);
-	std::optional<Dish> getDish(int dishId, std::string& errMsg);
-	std::optional<int> createDish(const Dish& dish, std::string& errMsg);
+	std::vector<Dish> getAllDishes(std::string& errMsg) override;
+	std::vector<Dish> getDishesPage(int afterId, int limit, std::string& errMsg) override;
+	std::optional<Dish> getDish(int dishId, std::string& errMsg) override;
+	std::optional<int> createDish(const Dish& dish, std::string& errMsg) override;
+	// One transaction with a single reused upsert statement.
+	std::optional<int> upsertDishes(const std::vector<Dish>& dishes, std::string& errMsg) override;
 	bool updateDish(int dishId,
 		const std::optional<std::string>& name,
 		const std::optional<std::string>& description,
 		const std::optional<std::string>& category,
 		const std::optional<double>& price,
 		const std::optional<bool>& isAvailable,
-		std::string& errMsg);
+		std::string& errMsg) override;
 
 	// User & merchant management
-	bool createUser(const std::string& username, const std::string& passwordHash, const std::string& phone, std::string& errMsg);
-	bool createMerchant(const std::string& username, const std::string& passwordHash, const std::string& storeName, std::string& errMsg);
-	std::optional<User> getUserByUsername(const std::string& username, std::string& errMsg);
-	std::optional<Merchant> getMerchantByUsername(const std::string& username, std::string& errMsg);
-	std::optional<User> getUserById(int id, std::string& errMsg);
-	std::optional<Merchant> getMerchantById(int id, std::string& errMsg);
+	bool createUser(const std::string& username, const std::string& passwordHash, const std::string& phone, std::string& errMsg) override;
+	bool createMerchant(const std::string& username, const std::string& passwordHash, const std::string& storeName, std::string& errMsg) override;
+	std::optional<User> getUserByUsername(const std::string& username, std::string& errMsg) override;
+	std::optional<Merchant> getMerchantByUsername(const std::string& username, std::string& errMsg) override;
+	std::optional<User> getUserById(int id, std::string& errMsg) override;
+	std::optional<Merchant> getMerchantById(int id, std::string& errMsg) override;
 
 	// Session tokens
-	bool createSessionToken(const std::string& token, const std::optional<int>& userId, const std::optional<int>& merchantId, const std::string& expiresAt, std::string& errMsg);
-	std::optional<Session> getSessionByToken(const std::string& token, std::string& errMsg);
+	bool createSessionToken(const std::string& token, const std::optional<int>& userId, const std::optional<int>& merchantId, EpochMillis expiresAt, std::string& errMsg) override;
+	std::optional<Session> getSessionByToken(const std::string& token, std::string& errMsg) override;
+	// One short write per call.
+	std::optional<int> deleteExpiredSessions(int batchSize, std::string& errMsg) override;
+
+	std::optional<int> createOrder(const std::vector<OrderItem>& items, const std::optional<int>& userId, std::string& errMsg) override;
+	std::optional<Order> getOrder(int orderId, std::string& errMsg) override;
+	// includeArchived also reads the attached archive (see attachArchive).
+	std::vector<Order> getAllOrders(std::string& errMsg, bool includeArchived = false) override;
+	std::vector<Order> getOrdersByUser(int userId, std::string& errMsg, bool includeArchived = false) override;
+	std::vector<Order> getActiveOrders(std::string& errMsg) override;
+	std::vector<Order> getAllOrdersPage(const std::optional<int>& beforeId, int limit, std::string& errMsg, bool includeArchived = false) override;
+	std::vector<Order> getOrdersByUserPage(int userId, const std::optional<int>& beforeId, int limit, std::string& errMsg, bool includeArchived = false) override;
+	bool updateOrderStatus(int orderId, const std::string& status, std::string& errMsg) override;
+	// One transaction, or one log sync with the event log.
+	std::optional<std::vector<std::optional<Order>>> updateOrderStatuses(const std::vector<OrderStatusUpdate>& updates, std::string& errMsg) override;
+	bool markOrderPickupNotified(int orderId, std::string& errMsg) override;
 
-	// Returns created order id
-	std::optional<int> createOrder(const std::vector<OrderItem>& items, const std::optional<int>& userId, std::string& errMsg);
-	std::optional<Order> getOrder(int orderId, std::string& errMsg);
-	std::vector<Order> getAllOrders(std::string& errMsg);
-	std::vector<Order> getOrdersByUser(int userId, std::string& errMsg);
-	bool updateOrderStatus(int orderId, const std::string& status, std::string& errMsg);
-	bool markOrderPickupNotified(int orderId, std::string& errMsg);
+	// Answered from daily_sales/dish_sales rather than by scanning orders;
+	// both halves come from the same snapshot.
+	SalesReport getSalesReport(EpochDay fromDay, EpochDay toDay, std::string& errMsg) override;
+
+	// Attaches a second SQLite file as schema "archive" on every connection,
+	// creating its tables if needed. getOrder then falls back to it.
+	bool attachArchive(const std::string& path, std::string& errMsg);
+	// Moves completed, pickup-acknowledged orders last updated more than
+	// olderThanDays ago into the archive, batchSize orders per transaction.
+	// Returns how many orders were moved.
+	std::optional<int> archiveCompletedOrders(int olderThanDays, int batchSize, std::string& errMsg);
+
+	// Online copy of one schema ("main", or "archive" once attached) to
+	// destPath via the SQLite backup API, pagesPerStep pages at a time. The
+	// writer is held only for each step and released for `pause` in between,
+	// and its own writes are carried into the copy without restarting it. The
+	// file is written under destPath.partial and renamed when complete.
+	// onProgress gets (remaining, total) pages.
+	bool backupTo(const std::string& schema, const std::string& destPath, int pagesPerStep, std::chrono::milliseconds pause,
+		const std::function<void(int, int)>& onProgress, std::string& errMsg);
+	bool isArchiveAttached() const { return archiveAttached; }
+
+	StatementCacheStats statementCacheStats();
+
+	// Routes createOrder through a background writer that commits up to
+	// maxBatch orders per transaction, waiting at most maxWaitMicros for a
+	// batch to fill. Call once after open().
+	void enableGroupCommit(size_t maxBatch, int maxWaitMicros);
+	// Makes order writes log-first: createOrder, updateOrderStatus and
+	// markOrderPickupNotified append an event to an OrderEventLog in dir and
+	// return once it is synced; a background thread then applies the events
+	// to SQLite. getOrder sees unapplied changes, listings catch up within
+	// milliseconds. Replays events SQLite has not applied yet, so call once
+	// after open() and before anything reads orders. Takes precedence over
+	// group commit.
+	bool enableEventLog(const std::string& dir, size_t segmentBytes, std::string& errMsg);
 
 private:
 	Database() = default;
-	~Database();
+	~Database() override;
 	Database(const Database&) = delete;
 	Database& operator=(const Database&) = delete;
 
-	sqlite3* db{nullptr};
+	// Cached statements are stateful, so each method holds its lease for the
+	// whole prepare/step/reset cycle.
+	ConnectionLease writer();
+	ConnectionLease reader();
+	bool openReaders(const std::string& path, int count, std::string& errMsg);
+	// Fails if a hot query is not planned with the index meant for it.
+	bool verifyIndexUsage(std::string& errMsg);
+
+	// Runs a parameterless statement (BEGIN/COMMIT/ROLLBACK) through the cache.
+	static bool execCached(const ConnectionLease& conn, const char* sql, std::string& errMsg);
+
+	// Fills dishTable from the dishes table; done once in open().
+	bool loadDishTable(const ConnectionLease& conn, std::string& errMsg);
+	static std::optional<int> writeOrder(const ConnectionLease& conn, const std::optional<int>& orderId, const std::optional<int>& userId,
+		const std::vector<OrderItem>& pricedItems, EpochMillis createdAt, std::string& errMsg);
+	static bool applyStatusChange(const ConnectionLease& conn, int orderId, const std::string& status, EpochMillis at, std::string& errMsg);
+	static bool applyPickupNotified(const ConnectionLease& conn, int orderId, EpochMillis at, std::string& errMsg);
+	// getOrder without the unapplied-event overlay; withArchive falls back to
+	// the archive when the order is not live. Writes resolve live rows only.
+	std::optional<Order> readOrder(int orderId, bool withArchive, std::string& errMsg);
+	void commitOrderBatch(std::vector<OrderRequest*>& batch);
+	// Adds the deltas to the day's daily_sales row inside the caller's transaction.
+	static std::vector<DailySales> readDailySales(const ConnectionLease& conn, EpochDay fromDay, EpochDay toDay, std::string& errMsg);
+	static std::vector<DishSales> readDishSales(const ConnectionLease& conn, EpochDay fromDay, EpochDay toDay, std::string& errMsg);
+	static bool addDailySales(const ConnectionLease& conn, EpochDay day, int orders, double revenue, int completed, double completedRevenue, std::string& errMsg);
+	std::optional<Order> getArchivedOrder(const ConnectionLease& conn, int orderId, std::string& errMsg);
+	bool fillArchivedResults(const ConnectionLease& conn, const std::vector<OrderStatusUpdate>& updates,
+		std::vector<std::optional<Order>>& results, std::string& errMsg);
+	// Runs an orders/order_items JOIN query, plus its archive twin when asked,
+	// and merges both newest first (capped at limit when limit > 0).
+	std::vector<Order> queryOrders(const char* sql, const std::function<void(sqlite3_stmt*)>& bind, bool includeArchived, int limit, std::string& errMsg);
+
+	// Log-first order writes (enableEventLog).
+	std::optional<int> logOrderCreated(const std::vector<OrderItem>& pricedItems, const std::optional<int>& userId, std::string& errMsg);
+	bool logOrderChange(int orderId, OrderEventType type, const std::string& status, std::string& errMsg);
+	// Appends one change and updates the overlay; caller holds eventMutex.
+	// Returns the order after the change, or nullopt for an unknown id (errMsg
+	// empty) or a failed append.
+	std::optional<Order> appendOrderChangeLocked(OrderEvent& event, std::string& errMsg);
+	bool applyEvents(const std::vector<OrderEvent>& events, std::string& errMsg);
+	void runEventApplier();
+	void stopEventLog();
+
+	DbConnection writerConn;
+	// Mirrors dish prices and availability for pricing carts outside the
+	// write transaction; the dish writers update it after they commit.
+	DishTable dishTable;
+	std::vector<std::unique_ptr<DbConnection>> readers;
+	std::atomic<size_t> nextReader{0};
+	std::unique_ptr<GroupCommitWriter> groupCommit;
+	std::atomic<bool> archiveAttached{false};
+	std::unique_ptr<OrderEventLog> eventLog;
+	// Guards the fields below.
+	std::mutex eventMutex;
+	std::condition_variable eventsQueued;
+	// Logged but not yet applied to SQLite, in lsn order.
+	std::deque<OrderEvent> unappliedEvents;
+	// Current state of each order with unapplied events, with its last lsn.
+	std::unordered_map<int, std::pair<uint64_t, Order>> unappliedOrders;
+	int nextOrderId{1};
+	bool stopApplier{false};
+	std::thread eventApplier;
 };
 
 
@@ -0,0 +1,108 @@
+#include "DishTable.h"
+#include <algorithm>
+
+namespace {
+	bool testBit(const std::vector<uint64_t>& bits, int id) {
+		const size_t word = static_cast<size_t>(id) / 64;
+		return word < bits.size() && (bits[word] >> (id % 64)) & 1;
+	}
+
+	void assignBit(std::vector<uint64_t>& bits, int id, bool value) {
+		const uint64_t mask = 1ull << (id % 64);
+		uint64_t& word = bits[static_cast<size_t>(id) / 64];
+		word = value ? (word | mask) : (word & ~mask);
+	}
+}
+
+bool DishTable::Tables::isKnown(int dishId) const {
+	return dishId > 0 && testBit(known, dishId);
+}
+
+void DishTable::Tables::assign(const DishPrice& dish) {
+	if (dish.dishId <= 0) {
+		return;
+	}
+	if (dish.dishId > kMaxDenseId) {
+		sparse[dish.dishId] = dish;
+		return;
+	}
+	if (static_cast<size_t>(dish.dishId) >= prices.size()) {
+		// Leave headroom so the next few new dishes do not each reallocate.
+		const size_t size = std::max<size_t>(static_cast<size_t>(dish.dishId) + 1, prices.size() * 2);
+		prices.resize(size, 0.0);
+		known.resize((size + 63) / 64, 0);
+		available.resize((size + 63) / 64, 0);
+	}
+	prices[dish.dishId] = dish.price;
+	assignBit(known, dish.dishId, true);
+	assignBit(available, dish.dishId, dish.isAvailable);
+}
+
+std::shared_ptr<DishTable::Tables> DishTable::copyLocked() const {
+	const auto current = tables.load();
+	return current ? std::make_shared<Tables>(*current) : std::make_shared<Tables>();
+}
+
+void DishTable::clear() {
+	std::lock_guard<std::mutex> lock(writeMutex);
+	tables.store(nullptr);
+}
+
+void DishTable::set(const std::vector<DishPrice>& dishes) {
+	std::lock_guard<std::mutex> lock(writeMutex);
+	auto next = copyLocked();
+	for (const auto& dish : dishes) {
+		next->assign(dish);
+	}
+	tables.store(std::move(next));
+}
+
+void DishTable::update(int dishId, const std::optional<double>& price, const std::optional<bool>& isAvailable) {
+	std::lock_guard<std::mutex> lock(writeMutex);
+	const auto current = tables.load();
+	if (!current) {
+		return;
+	}
+	DishPrice dish{dishId, 0.0, false};
+	if (dishId > kMaxDenseId) {
+		const auto it = current->sparse.find(dishId);
+		if (it == current->sparse.end()) return;
+		dish = it->second;
+	} else if (current->isKnown(dishId)) {
+		dish.price = current->prices[dishId];
+		dish.isAvailable = testBit(current->available, dishId);
+	} else {
+		return;
+	}
+	if (price) dish.price = *price;
+	if (isAvailable) dish.isAvailable = *isAvailable;
+	auto next = copyLocked();
+	next->assign(dish);
+	tables.store(std::move(next));
+}
+
+std::optional<std::vector<OrderItem>> DishTable::priceItems(const std::vector<OrderItem>& items, std::string& errMsg) const {
+	const auto current = tables.load();
+	std::vector<OrderItem> priced;
+	priced.reserve(items.size());
+	for (const auto& item : items) {
+		double price = 0.0;
+		bool ok = false;
+		if (!current) {
+			// Not loaded: nothing can be priced.
+		} else if (item.dishId > kMaxDenseId) {
+			const auto it = current->sparse.find(item.dishId);
+			ok = it != current->sparse.end() && it->second.isAvailable;
+			if (ok) price = it->second.price;
+		} else if (current->isKnown(item.dishId) && testBit(current->available, item.dishId)) {
+			ok = true;
+			price = current->prices[item.dishId];
+		}
+		if (!ok) {
+			errMsg = "Dish not available";
+			return std::nullopt;
+		}
+		priced.push_back(OrderItem{item.dishId, item.quantity, price});
+	}
+	return priced;
+}
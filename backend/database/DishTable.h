@@ -0,0 +1,58 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "../models/Order.h"
+#include "Published.h"
+
+struct DishPrice {
+	int dishId;
+	double price;
+	bool isAvailable;
+};
+
+// Price and availability of every dish, indexed by id, so a cart is priced
+// with array lookups instead of one query per line. Dish ids are SQLite
+// rowids and therefore small and dense; the rare id past kMaxDenseId (only
+// possible through an import naming it) goes to a side map.
+//
+// Copy-on-write: readers price against an immutable version, taking no lock
+// unless it changed since their last read (see Published); writers copy it,
+// apply their change and publish the copy. Dish
+// writes are rare next to orders, and the table is a few bytes per dish.
+class DishTable {
+public:
+	static constexpr int kMaxDenseId = 1 << 20;
+
+	void clear();
+	// Adds or replaces all given dishes in one new version.
+	void set(const std::vector<DishPrice>& dishes);
+	// Leaves fields that are not given unchanged; an unknown id is ignored.
+	void update(int dishId, const std::optional<double>& price, const std::optional<bool>& isAvailable);
+	// Copies items with unit prices filled in; fails if a dish is unknown or
+	// unavailable.
+	std::optional<std::vector<OrderItem>> priceItems(const std::vector<OrderItem>& items, std::string& errMsg) const;
+
+private:
+	struct Tables {
+		std::vector<double> prices;
+		// One bit per id; a dish is known once it has been set.
+		std::vector<uint64_t> known;
+		std::vector<uint64_t> available;
+		std::unordered_map<int, DishPrice> sparse;
+
+		bool isKnown(int dishId) const;
+		void assign(const DishPrice& dish);
+	};
+
+	// A private copy of the current version for a writer to change.
+	std::shared_ptr<Tables> copyLocked() const;
+
+	// Serializes writers; readers never take it.
+	std::mutex writeMutex;
+	Published<Tables> tables;
+};
@@ -0,0 +1,61 @@
+#include "GroupCommitWriter.h"
+
+GroupCommitWriter::GroupCommitWriter(CommitFn commit, size_t maxBatch, std::chrono::microseconds maxWait)
+	: commit(std::move(commit)), maxBatch(maxBatch > 0 ? maxBatch : 1), maxWait(maxWait) {
+	worker = std::thread([this]() { run(); });
+}
+
+GroupCommitWriter::~GroupCommitWriter() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	queued.notify_all();
+	if (worker.joinable()) {
+		worker.join();
+	}
+}
+
+void GroupCommitWriter::submit(OrderRequest& request) {
+	std::promise<void> done;
+	auto committed = done.get_future();
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (stopping) {
+			request.errMsg = "order writer is shutting down";
+			return;
+		}
+		queue.push_back(Pending{&request, &done});
+	}
+	queued.notify_one();
+	committed.wait();
+}
+
+void GroupCommitWriter::run() {
+	std::vector<Pending> taken;
+	std::vector<OrderRequest*> batch;
+	while (true) {
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			queued.wait(lock, [&]() { return stopping || !queue.empty(); });
+			if (queue.empty()) {
+				return;
+			}
+			// Give other callers up to maxWait from now to join this batch.
+			const auto deadline = std::chrono::steady_clock::now() + maxWait;
+			queued.wait_until(lock, deadline, [&]() { return stopping || queue.size() >= maxBatch; });
+			const size_t count = std::min(queue.size(), maxBatch);
+			taken.assign(queue.begin(), queue.begin() + count);
+			queue.erase(queue.begin(), queue.begin() + count);
+		}
+
+		batch.clear();
+		for (const auto& pending : taken) {
+			batch.push_back(pending.request);
+		}
+		commit(batch);
+		for (const auto& pending : taken) {
+			pending.done->set_value();
+		}
+	}
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../models/Order.h"
+
+// One createOrder call waiting for its batch, with items already priced.
+// The committer fills in either orderId or errMsg.
+struct OrderRequest {
+	const std::vector<OrderItem>& items;
+	std::optional<int> userId;
+	std::optional<int> orderId;
+	std::string errMsg;
+};
+
+// Funnels concurrent order inserts into one background thread that commits
+// them in batches, so a lunch rush pays one write transaction (and fsync)
+// per batch instead of per order.
+class GroupCommitWriter {
+public:
+	using CommitFn = std::function<void(std::vector<OrderRequest*>& batch)>;
+
+	GroupCommitWriter(CommitFn commit, size_t maxBatch, std::chrono::microseconds maxWait);
+	~GroupCommitWriter();
+	GroupCommitWriter(const GroupCommitWriter&) = delete;
+	GroupCommitWriter& operator=(const GroupCommitWriter&) = delete;
+
+	// Blocks until the batch containing request has been committed.
+	void submit(OrderRequest& request);
+
+private:
+	struct Pending {
+		OrderRequest* request;
+		std::promise<void>* done;
+	};
+
+	void run();
+
+	CommitFn commit;
+	const size_t maxBatch;
+	const std::chrono::microseconds maxWait;
+	std::mutex mutex;
+	std::condition_variable queued;
+	std::deque<Pending> queue;
+	bool stopping{false};
+	std::thread worker;
+};
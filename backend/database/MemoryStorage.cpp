@@ -0,0 +1,462 @@
+#include "MemoryStorage.h"
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <queue>
+
+namespace {
+	// Same rows as the seed in Migrations.cpp.
+	const Dish kSeedMenu[] = {
+		{1, "Margherita Pizza", "Classic tomato, mozzarella and basil", "Pizza", 8.5, true},
+		{2, "Caesar Salad", "Romaine lettuce with parmesan and croutons", "Salad", 6.0, true},
+		{3, "Spaghetti Bolognese", "Slow cooked beef ragu", "Pasta", 9.5, true},
+		{4, "Cheeseburger", "Beef patty, cheddar, pickles", "Burger", 7.5, true},
+		{5, "Chicken Caesar Salad", "Grilled chicken with Caesar dressing", "Salad", 8.0, true},
+		{6, "Vegetable Stir Fry", "Seasonal veggies with soy glaze", "Wok", 6.5, true},
+		{7, "Fish and Chips", "Beer battered cod with fries", "Seafood", 10.0, true},
+		{8, "Tiramisu", "Espresso soaked ladyfingers and mascarpone", "Dessert", 5.5, true},
+		{9, "Lemonade", "Freshly squeezed lemon juice", "Drinks", 3.0, true},
+		{10, "Tomato Soup", "Roasted tomato soup with basil oil", "Soup", 5.0, true},
+	};
+
+	const std::set<int> kNoOrderIds;
+
+	int orderIdOf(const std::pair<const int, Order>& entry) {
+		return entry.first;
+	}
+
+	int orderIdOf(int orderId) {
+		return orderId;
+	}
+
+	bool keepAll(const Order&) {
+		return true;
+	}
+
+	bool isActive(const Order& order) {
+		return order.status == "pending" || order.status == "preparing" || order.status == "ready" ||
+			(order.status == "completed" && !order.pickupNotified);
+	}
+}
+
+MemoryStorage::MemoryStorage() {
+	for (const auto& dish : kSeedMenu) {
+		dishes.emplace(dish.id, dish);
+	}
+}
+
+MemoryStorage::OrderStripe& MemoryStorage::orderStripe(int orderId) {
+	return orderStripes[static_cast<size_t>(orderId) % kStripes];
+}
+
+MemoryStorage::SessionStripe& MemoryStorage::sessionStripe(const std::string& token) {
+	return sessionStripes[std::hash<std::string>{}(token) % kStripes];
+}
+
+std::vector<Dish> MemoryStorage::getAllDishes(std::string&) {
+	std::shared_lock<std::shared_mutex> lock(dishMutex);
+	std::vector<Dish> result;
+	result.reserve(dishes.size());
+	for (const auto& entry : dishes) {
+		result.push_back(entry.second);
+	}
+	return result;
+}
+
+std::vector<Dish> MemoryStorage::getDishesPage(int afterId, int limit, std::string&) {
+	std::shared_lock<std::shared_mutex> lock(dishMutex);
+	std::vector<Dish> result;
+	for (auto it = dishes.upper_bound(afterId); it != dishes.end() && static_cast<int>(result.size()) < limit; ++it) {
+		result.push_back(it->second);
+	}
+	return result;
+}
+
+std::optional<Dish> MemoryStorage::getDish(int dishId, std::string&) {
+	std::shared_lock<std::shared_mutex> lock(dishMutex);
+	const auto it = dishes.find(dishId);
+	if (it == dishes.end()) {
+		return std::nullopt;
+	}
+	return it->second;
+}
+
+// Like an INTEGER PRIMARY KEY: id 0 takes the largest id + 1.
+std::optional<int> MemoryStorage::insertDishLocked(const Dish& dish) {
+	Dish stored = dish;
+	if (stored.id <= 0) {
+		stored.id = dishes.empty() ? 1 : dishes.rbegin()->first + 1;
+	}
+	dishes[stored.id] = stored;
+	return stored.id;
+}
+
+std::optional<int> MemoryStorage::createDish(const Dish& dish, std::string&) {
+	std::unique_lock<std::shared_mutex> lock(dishMutex);
+	Dish created = dish;
+	created.id = 0;
+	return insertDishLocked(created);
+}
+
+std::optional<int> MemoryStorage::upsertDishes(const std::vector<Dish>& rows, std::string&) {
+	std::unique_lock<std::shared_mutex> lock(dishMutex);
+	for (const auto& dish : rows) {
+		insertDishLocked(dish);
+	}
+	return static_cast<int>(rows.size());
+}
+
+bool MemoryStorage::updateDish(int dishId,
+	const std::optional<std::string>& name,
+	const std::optional<std::string>& description,
+	const std::optional<std::string>& category,
+	const std::optional<double>& price,
+	const std::optional<bool>& isAvailable,
+	std::string&) {
+	std::unique_lock<std::shared_mutex> lock(dishMutex);
+	const auto it = dishes.find(dishId);
+	if (it == dishes.end()) {
+		return true;
+	}
+	Dish& dish = it->second;
+	if (name) dish.name = *name;
+	if (description) dish.description = *description;
+	if (category) dish.category = *category;
+	if (price) dish.price = *price;
+	if (isAvailable) dish.isAvailable = *isAvailable;
+	return true;
+}
+
+bool MemoryStorage::createUser(const std::string& username, const std::string& passwordHash, const std::string& phone, std::string& errMsg) {
+	std::unique_lock<std::shared_mutex> lock(accountMutex);
+	if (userIdsByName.count(username)) {
+		errMsg = "UNIQUE constraint failed: users.username";
+		return false;
+	}
+	const int id = nextUserId++;
+	users[id] = User{id, username, passwordHash, phone, formatEpochMillis(nowEpochMillis())};
+	userIdsByName[username] = id;
+	return true;
+}
+
+bool MemoryStorage::createMerchant(const std::string& username, const std::string& passwordHash, const std::string& storeName, std::string& errMsg) {
+	std::unique_lock<std::shared_mutex> lock(accountMutex);
+	if (merchantIdsByName.count(username)) {
+		errMsg = "UNIQUE constraint failed: merchants.username";
+		return false;
+	}
+	const int id = nextMerchantId++;
+	merchants[id] = Merchant{id, username, passwordHash, storeName, formatEpochMillis(nowEpochMillis())};
+	merchantIdsByName[username] = id;
+	return true;
+}
+
+std::optional<User> MemoryStorage::getUserByUsername(const std::string& username, std::string&) {
+	std::shared_lock<std::shared_mutex> lock(accountMutex);
+	const auto it = userIdsByName.find(username);
+	if (it == userIdsByName.end()) {
+		return std::nullopt;
+	}
+	return users.at(it->second);
+}
+
+std::optional<Merchant> MemoryStorage::getMerchantByUsername(const std::string& username, std::string&) {
+	std::shared_lock<std::shared_mutex> lock(accountMutex);
+	const auto it = merchantIdsByName.find(username);
+	if (it == merchantIdsByName.end()) {
+		return std::nullopt;
+	}
+	return merchants.at(it->second);
+}
+
+std::optional<User> MemoryStorage::getUserById(int id, std::string&) {
+	std::shared_lock<std::shared_mutex> lock(accountMutex);
+	const auto it = users.find(id);
+	if (it == users.end()) {
+		return std::nullopt;
+	}
+	return it->second;
+}
+
+std::optional<Merchant> MemoryStorage::getMerchantById(int id, std::string&) {
+	std::shared_lock<std::shared_mutex> lock(accountMutex);
+	const auto it = merchants.find(id);
+	if (it == merchants.end()) {
+		return std::nullopt;
+	}
+	return it->second;
+}
+
+bool MemoryStorage::createSessionToken(const std::string& token, const std::optional<int>& userId, const std::optional<int>& merchantId, EpochMillis expiresAt, std::string& errMsg) {
+	{
+		std::shared_lock<std::shared_mutex> lock(accountMutex);
+		if ((userId && !users.count(*userId)) || (merchantId && !merchants.count(*merchantId))) {
+			errMsg = "FOREIGN KEY constraint failed";
+			return false;
+		}
+	}
+	auto& stripe = sessionStripe(token);
+	std::unique_lock<std::shared_mutex> lock(stripe.mutex);
+	if (stripe.sessions.count(token)) {
+		errMsg = "UNIQUE constraint failed: sessions.token";
+		return false;
+	}
+	stripe.sessions[token] = Session{nextSessionId++, token, userId, merchantId, expiresAt, nowEpochMillis()};
+	return true;
+}
+
+std::optional<Session> MemoryStorage::getSessionByToken(const std::string& token, std::string&) {
+	auto& stripe = sessionStripe(token);
+	std::shared_lock<std::shared_mutex> lock(stripe.mutex);
+	const auto it = stripe.sessions.find(token);
+	if (it == stripe.sessions.end() || it->second.expiresAt <= nowEpochMillis()) {
+		return std::nullopt;
+	}
+	return it->second;
+}
+
+std::optional<int> MemoryStorage::deleteExpiredSessions(int batchSize, std::string&) {
+	const EpochMillis now = nowEpochMillis();
+	int removed = 0;
+	for (auto& stripe : sessionStripes) {
+		std::unique_lock<std::shared_mutex> lock(stripe.mutex);
+		for (auto it = stripe.sessions.begin(); it != stripe.sessions.end() && removed < batchSize;) {
+			if (it->second.expiresAt <= now) {
+				it = stripe.sessions.erase(it);
+				++removed;
+			} else {
+				++it;
+			}
+		}
+		if (removed >= batchSize) {
+			break;
+		}
+	}
+	return removed;
+}
+
+std::optional<int> MemoryStorage::createOrder(const std::vector<OrderItem>& items, const std::optional<int>& userId, std::string& errMsg) {
+	if (items.empty()) {
+		errMsg = "Order items cannot be empty";
+		return std::nullopt;
+	}
+	if (userId) {
+		std::shared_lock<std::shared_mutex> lock(accountMutex);
+		if (!users.count(*userId)) {
+			errMsg = "FOREIGN KEY constraint failed";
+			return std::nullopt;
+		}
+	}
+
+	Order order{};
+	order.userId = userId;
+	order.status = "pending";
+	order.items.reserve(items.size());
+	{
+		std::shared_lock<std::shared_mutex> lock(dishMutex);
+		for (const auto& item : items) {
+			const auto it = dishes.find(item.dishId);
+			if (it == dishes.end() || !it->second.isAvailable) {
+				errMsg = "Dish not available";
+				return std::nullopt;
+			}
+			order.items.push_back(OrderItem{item.dishId, item.quantity, it->second.price});
+			order.total += it->second.price * item.quantity;
+		}
+	}
+	order.createdAt = nowEpochMillis();
+	order.updatedAt = order.createdAt;
+	order.id = nextOrderId.fetch_add(1);
+
+	auto& stripe = orderStripe(order.id);
+	std::unique_lock<std::shared_mutex> lock(stripe.mutex);
+	{
+		std::lock_guard<std::mutex> salesLock(salesMutex);
+		const EpochDay day = epochDayOf(order.createdAt);
+		auto& daily = dailySales.emplace(day, DailySales{day, 0, 0.0, 0, 0.0}).first->second;
+		daily.orderCount += 1;
+		daily.revenue += order.total;
+		for (const auto& item : order.items) {
+			auto& totals = dishSales.emplace(std::make_pair(day, item.dishId), DishTotals{0, 0.0}).first->second;
+			totals.quantity += item.quantity;
+			totals.revenue += item.quantity * item.unitPrice;
+		}
+	}
+	const int id = order.id;
+	if (userId) {
+		stripe.orderIdsByUser[*userId].insert(id);
+	}
+	stripe.orders.emplace(id, std::move(order));
+	return id;
+}
+
+std::optional<Order> MemoryStorage::getOrder(int orderId, std::string&) {
+	auto& stripe = orderStripe(orderId);
+	std::shared_lock<std::shared_mutex> lock(stripe.mutex);
+	const auto it = stripe.orders.find(orderId);
+	if (it == stripe.orders.end()) {
+		return std::nullopt;
+	}
+	return it->second;
+}
+
+template <typename Range, typename Keep>
+std::vector<Order> MemoryStorage::mergeOrders(Range range, Keep keep, int limit) {
+	using Iterator = decltype(range(orderStripes[0]).first);
+	struct Cursor {
+		int id;
+		size_t stripe;
+		Iterator it;
+		bool operator<(const Cursor& other) const { return id < other.id; }
+	};
+	// Read locks go in index order, as batch updates take theirs.
+	std::vector<std::shared_lock<std::shared_mutex>> locks;
+	locks.reserve(kStripes);
+	std::array<Iterator, kStripes> begins{};
+	std::priority_queue<Cursor> heads;
+	for (size_t i = 0; i < kStripes; ++i) {
+		locks.emplace_back(orderStripes[i].mutex);
+		const auto ids = range(orderStripes[i]);
+		begins[i] = ids.first;
+		if (ids.first != ids.second) {
+			const auto last = std::prev(ids.second);
+			heads.push(Cursor{orderIdOf(*last), i, last});
+		}
+	}
+	std::vector<Order> result;
+	while (!heads.empty() && (limit <= 0 || static_cast<int>(result.size()) < limit)) {
+		Cursor head = heads.top();
+		heads.pop();
+		const Order& order = orderStripes[head.stripe].orders.find(head.id)->second;
+		if (keep(order)) {
+			result.push_back(order);
+		}
+		if (head.it != begins[head.stripe]) {
+			--head.it;
+			head.id = orderIdOf(*head.it);
+			heads.push(head);
+		}
+	}
+	return result;
+}
+
+std::vector<Order> MemoryStorage::getAllOrders(std::string& errMsg, bool includeArchived) {
+	return getAllOrdersPage(std::nullopt, 0, errMsg, includeArchived);
+}
+
+std::vector<Order> MemoryStorage::getOrdersByUser(int userId, std::string& errMsg, bool includeArchived) {
+	return getOrdersByUserPage(userId, std::nullopt, 0, errMsg, includeArchived);
+}
+
+std::vector<Order> MemoryStorage::getActiveOrders(std::string&) {
+	return mergeOrders([](const OrderStripe& stripe) {
+		return std::make_pair(stripe.orders.begin(), stripe.orders.end());
+	}, isActive, 0);
+}
+
+std::vector<Order> MemoryStorage::getAllOrdersPage(const std::optional<int>& beforeId, int limit, std::string&, bool) {
+	return mergeOrders([&](const OrderStripe& stripe) {
+		return std::make_pair(stripe.orders.begin(), beforeId ? stripe.orders.lower_bound(*beforeId) : stripe.orders.end());
+	}, keepAll, limit);
+}
+
+std::vector<Order> MemoryStorage::getOrdersByUserPage(int userId, const std::optional<int>& beforeId, int limit, std::string&, bool) {
+	return mergeOrders([&](const OrderStripe& stripe) {
+		const auto it = stripe.orderIdsByUser.find(userId);
+		const std::set<int>& ids = it == stripe.orderIdsByUser.end() ? kNoOrderIds : it->second;
+		return std::make_pair(ids.begin(), beforeId ? ids.lower_bound(*beforeId) : ids.end());
+	}, keepAll, limit);
+}
+
+// Moves the total in or out of the completed aggregate, as Database does.
+void MemoryStorage::applyStatusLocked(Order& order, const std::string& status, EpochMillis at) {
+	const int completedDelta = (status == "completed") - (order.status == "completed");
+	order.status = status;
+	order.updatedAt = at;
+	if (completedDelta != 0) {
+		std::lock_guard<std::mutex> salesLock(salesMutex);
+		auto& daily = dailySales[epochDayOf(order.createdAt)];
+		daily.completedCount += completedDelta;
+		daily.completedRevenue += completedDelta * order.total;
+	}
+}
+
+bool MemoryStorage::updateOrderStatus(int orderId, const std::string& status, std::string&) {
+	auto& stripe = orderStripe(orderId);
+	std::unique_lock<std::shared_mutex> lock(stripe.mutex);
+	const auto it = stripe.orders.find(orderId);
+	if (it != stripe.orders.end()) {
+		applyStatusLocked(it->second, status, nowEpochMillis());
+	}
+	return true;
+}
+
+std::optional<std::vector<std::optional<Order>>> MemoryStorage::updateOrderStatuses(const std::vector<OrderStatusUpdate>& updates, std::string&) {
+	// Stripes are locked in index order so concurrent batches cannot deadlock.
+	std::array<bool, kStripes> touched{};
+	for (const auto& update : updates) {
+		touched[static_cast<size_t>(update.orderId) % kStripes] = true;
+	}
+	std::vector<std::unique_lock<std::shared_mutex>> locks;
+	for (size_t i = 0; i < kStripes; ++i) {
+		if (touched[i]) {
+			locks.emplace_back(orderStripes[i].mutex);
+		}
+	}
+
+	const EpochMillis now = nowEpochMillis();
+	for (const auto& update : updates) {
+		auto& orders = orderStripe(update.orderId).orders;
+		const auto it = orders.find(update.orderId);
+		if (it != orders.end()) {
+			applyStatusLocked(it->second, update.status, now);
+		}
+	}
+	std::vector<std::optional<Order>> results;
+	results.reserve(updates.size());
+	for (const auto& update : updates) {
+		auto& orders = orderStripe(update.orderId).orders;
+		const auto it = orders.find(update.orderId);
+		results.push_back(it == orders.end() ? std::nullopt : std::optional<Order>(it->second));
+	}
+	return results;
+}
+
+bool MemoryStorage::markOrderPickupNotified(int orderId, std::string&) {
+	auto& stripe = orderStripe(orderId);
+	std::unique_lock<std::shared_mutex> lock(stripe.mutex);
+	const auto it = stripe.orders.find(orderId);
+	if (it != stripe.orders.end()) {
+		it->second.pickupNotified = true;
+		it->second.updatedAt = nowEpochMillis();
+	}
+	return true;
+}
+
+SalesReport MemoryStorage::getSalesReport(EpochDay fromDay, EpochDay toDay, std::string&) {
+	SalesReport report;
+	std::map<int, DishTotals> byDish;
+	{
+		std::lock_guard<std::mutex> salesLock(salesMutex);
+		for (auto it = dailySales.lower_bound(fromDay); it != dailySales.end() && it->first <= toDay; ++it) {
+			report.days.push_back(it->second);
+		}
+		for (auto it = dishSales.lower_bound({fromDay, 0}); it != dishSales.end() && it->first.first <= toDay; ++it) {
+			auto& totals = byDish.emplace(it->first.second, DishTotals{0, 0.0}).first->second;
+			totals.quantity += it->second.quantity;
+			totals.revenue += it->second.revenue;
+		}
+	}
+	{
+		std::shared_lock<std::shared_mutex> lock(dishMutex);
+		for (const auto& entry : byDish) {
+			const auto dish = dishes.find(entry.first);
+			report.dishes.push_back(DishSales{entry.first, dish == dishes.end() ? "" : dish->second.name, entry.second.quantity, entry.second.revenue});
+		}
+	}
+	// Best sellers first, ties by dish id.
+	std::stable_sort(report.dishes.begin(), report.dishes.end(), [](const DishSales& a, const DishSales& b) {
+		return a.revenue > b.revenue;
+	});
+	return report;
+}
@@ -0,0 +1,112 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <set>
+#include <shared_mutex>
+#include <unordered_map>
+#include <utility>
+#include "Storage.h"
+
+// Storage kept entirely in process memory, for benchmarking the HTTP and
+// service layers without SQLite. Nothing survives a restart. Orders and
+// sessions are split over lock stripes by id/token so unrelated requests do
+// not contend; the menu and accounts are small and read-mostly, so each sits
+// behind one shared_mutex. Starts with the same seed menu as a new database.
+class MemoryStorage : public Storage {
+public:
+	MemoryStorage();
+
+	std::vector<Dish> getAllDishes(std::string& errMsg) override;
+	std::vector<Dish> getDishesPage(int afterId, int limit, std::string& errMsg) override;
+	std::optional<Dish> getDish(int dishId, std::string& errMsg) override;
+	std::optional<int> createDish(const Dish& dish, std::string& errMsg) override;
+	std::optional<int> upsertDishes(const std::vector<Dish>& dishes, std::string& errMsg) override;
+	bool updateDish(int dishId,
+		const std::optional<std::string>& name,
+		const std::optional<std::string>& description,
+		const std::optional<std::string>& category,
+		const std::optional<double>& price,
+		const std::optional<bool>& isAvailable,
+		std::string& errMsg) override;
+
+	bool createUser(const std::string& username, const std::string& passwordHash, const std::string& phone, std::string& errMsg) override;
+	bool createMerchant(const std::string& username, const std::string& passwordHash, const std::string& storeName, std::string& errMsg) override;
+	std::optional<User> getUserByUsername(const std::string& username, std::string& errMsg) override;
+	std::optional<Merchant> getMerchantByUsername(const std::string& username, std::string& errMsg) override;
+	std::optional<User> getUserById(int id, std::string& errMsg) override;
+	std::optional<Merchant> getMerchantById(int id, std::string& errMsg) override;
+
+	bool createSessionToken(const std::string& token, const std::optional<int>& userId, const std::optional<int>& merchantId, EpochMillis expiresAt, std::string& errMsg) override;
+	std::optional<Session> getSessionByToken(const std::string& token, std::string& errMsg) override;
+	std::optional<int> deleteExpiredSessions(int batchSize, std::string& errMsg) override;
+
+	std::optional<int> createOrder(const std::vector<OrderItem>& items, const std::optional<int>& userId, std::string& errMsg) override;
+	std::optional<Order> getOrder(int orderId, std::string& errMsg) override;
+	// Listings read-lock every order stripe, so like SQLite each is a single
+	// snapshot; a page costs the same however many orders are stored.
+	std::vector<Order> getAllOrders(std::string& errMsg, bool includeArchived = false) override;
+	std::vector<Order> getOrdersByUser(int userId, std::string& errMsg, bool includeArchived = false) override;
+	std::vector<Order> getActiveOrders(std::string& errMsg) override;
+	std::vector<Order> getAllOrdersPage(const std::optional<int>& beforeId, int limit, std::string& errMsg, bool includeArchived = false) override;
+	std::vector<Order> getOrdersByUserPage(int userId, const std::optional<int>& beforeId, int limit, std::string& errMsg, bool includeArchived = false) override;
+	bool updateOrderStatus(int orderId, const std::string& status, std::string& errMsg) override;
+	// Holds every stripe the batch touches, so no reader sees half of it.
+	std::optional<std::vector<std::optional<Order>>> updateOrderStatuses(const std::vector<OrderStatusUpdate>& updates, std::string& errMsg) override;
+	bool markOrderPickupNotified(int orderId, std::string& errMsg) override;
+
+	SalesReport getSalesReport(EpochDay fromDay, EpochDay toDay, std::string& errMsg) override;
+
+private:
+	static constexpr size_t kStripes = 16;
+
+	struct OrderStripe {
+		std::shared_mutex mutex;
+		std::map<int, Order> orders;
+		// Ids of the orders each user placed, for per-user listings.
+		std::unordered_map<int, std::set<int>> orderIdsByUser;
+	};
+	struct SessionStripe {
+		std::shared_mutex mutex;
+		std::unordered_map<std::string, Session> sessions;
+	};
+	struct DishTotals {
+		int quantity;
+		double revenue;
+	};
+
+	OrderStripe& orderStripe(int orderId);
+	SessionStripe& sessionStripe(const std::string& token);
+	// Newest first, at most limit (0 = all) orders accepted by keep.
+	// range(stripe) gives that stripe's candidate ids as an ascending
+	// [begin, end) range; the stripes are merged back from their ends, so
+	// only the orders returned are visited.
+	template <typename Range, typename Keep>
+	std::vector<Order> mergeOrders(Range range, Keep keep, int limit);
+	// Caller holds the order's stripe exclusively.
+	void applyStatusLocked(Order& order, const std::string& status, EpochMillis at);
+	std::optional<int> insertDishLocked(const Dish& dish);
+
+	std::shared_mutex dishMutex;
+	std::map<int, Dish> dishes;
+
+	std::shared_mutex accountMutex;
+	std::unordered_map<int, User> users;
+	std::unordered_map<std::string, int> userIdsByName;
+	std::unordered_map<int, Merchant> merchants;
+	std::unordered_map<std::string, int> merchantIdsByName;
+	int nextUserId{1};
+	int nextMerchantId{1};
+
+	std::array<OrderStripe, kStripes> orderStripes;
+	std::atomic<int> nextOrderId{1};
+
+	std::array<SessionStripe, kStripes> sessionStripes;
+	std::atomic<int> nextSessionId{1};
+
+	// Taken after an order stripe, never before one.
+	std::mutex salesMutex;
+	std::map<EpochDay, DailySales> dailySales;
+	std::map<std::pair<EpochDay, int>, DishTotals> dishSales;
+};
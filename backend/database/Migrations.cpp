@@ -0,0 +1,162 @@
+#include "Migrations.h"
+
+namespace {
+	// Tables are IF NOT EXISTS so databases created before versioning (or by
+	// db/schema.sql) adopt version 1 without changes. Seed dishes only into an
+	// empty menu.
+	constexpr char kBaseSchema[] = R"SQL(
+	CREATE TABLE IF NOT EXISTS users (
+		id INTEGER PRIMARY KEY,
+		username TEXT NOT NULL UNIQUE,
+		password_hash TEXT NOT NULL,
+		phone TEXT,
+		created_at TEXT NOT NULL DEFAULT CURRENT_TIMESTAMP
+	);
+	CREATE TABLE IF NOT EXISTS merchants (
+		id INTEGER PRIMARY KEY,
+		username TEXT NOT NULL UNIQUE,
+		password_hash TEXT NOT NULL,
+		store_name TEXT,
+		created_at TEXT NOT NULL DEFAULT CURRENT_TIMESTAMP
+	);
+	CREATE TABLE IF NOT EXISTS sessions (
+		id INTEGER PRIMARY KEY,
+		token TEXT NOT NULL UNIQUE,
+		user_id INTEGER,
+		merchant_id INTEGER,
+		expires_at TEXT NOT NULL,
+		created_at TEXT NOT NULL DEFAULT CURRENT_TIMESTAMP,
+		FOREIGN KEY(user_id) REFERENCES users(id) ON DELETE CASCADE,
+		FOREIGN KEY(merchant_id) REFERENCES merchants(id) ON DELETE CASCADE
+	);
+	CREATE TABLE IF NOT EXISTS dishes (
+		id INTEGER PRIMARY KEY,
+		name TEXT NOT NULL,
+		description TEXT,
+		category TEXT,
+		price REAL NOT NULL,
+		is_available INTEGER NOT NULL DEFAULT 1,
+		created_at TEXT NOT NULL DEFAULT CURRENT_TIMESTAMP,
+		updated_at TEXT NOT NULL DEFAULT CURRENT_TIMESTAMP
+	);
+	CREATE TABLE IF NOT EXISTS orders (
+		id INTEGER PRIMARY KEY,
+		user_id INTEGER,
+		status TEXT NOT NULL DEFAULT 'pending',
+		total REAL NOT NULL DEFAULT 0,
+		pickup_notified INTEGER NOT NULL DEFAULT 0,
+		created_at TEXT NOT NULL DEFAULT CURRENT_TIMESTAMP,
+		updated_at TEXT NOT NULL DEFAULT CURRENT_TIMESTAMP,
+		FOREIGN KEY(user_id) REFERENCES users(id) ON DELETE SET NULL
+	);
+	CREATE TABLE IF NOT EXISTS order_items (
+		id INTEGER PRIMARY KEY,
+		order_id INTEGER NOT NULL,
+		dish_id INTEGER NOT NULL,
+		quantity INTEGER NOT NULL,
+		unit_price REAL NOT NULL,
+		FOREIGN KEY(order_id) REFERENCES orders(id) ON DELETE CASCADE,
+		FOREIGN KEY(dish_id) REFERENCES dishes(id)
+	);
+	INSERT INTO dishes (id, name, description, category, price, is_available)
+	SELECT * FROM (VALUES
+		(1, 'Margherita Pizza', 'Classic tomato, mozzarella and basil', 'Pizza', 8.5, 1),
+		(2, 'Caesar Salad', 'Romaine lettuce with parmesan and croutons', 'Salad', 6.0, 1),
+		(3, 'Spaghetti Bolognese', 'Slow cooked beef ragu', 'Pasta', 9.5, 1),
+		(4, 'Cheeseburger', 'Beef patty, cheddar, pickles', 'Burger', 7.5, 1),
+		(5, 'Chicken Caesar Salad', 'Grilled chicken with Caesar dressing', 'Salad', 8.0, 1),
+		(6, 'Vegetable Stir Fry', 'Seasonal veggies with soy glaze', 'Wok', 6.5, 1),
+		(7, 'Fish and Chips', 'Beer battered cod with fries', 'Seafood', 10.0, 1),
+		(8, 'Tiramisu', 'Espresso soaked ladyfingers and mascarpone', 'Dessert', 5.5, 1),
+		(9, 'Lemonade', 'Freshly squeezed lemon juice', 'Drinks', 3.0, 1),
+		(10, 'Tomato Soup', 'Roasted tomato soup with basil oil', 'Soup', 5.0, 1)
+	)
+	WHERE NOT EXISTS (SELECT 1 FROM dishes);
+)SQL";
+
+	constexpr char kHotPathIndexes[] = R"SQL(
+	CREATE INDEX IF NOT EXISTS idx_order_items_order_id ON order_items(order_id);
+	CREATE INDEX IF NOT EXISTS idx_orders_user_id ON orders(user_id, id DESC);
+	CREATE INDEX IF NOT EXISTS idx_orders_status_id ON orders(status, id);
+	CREATE INDEX IF NOT EXISTS idx_sessions_expires_at ON sessions(expires_at);
+)SQL";
+
+	// Order and session times become INTEGER epoch milliseconds (UTC) so expiry
+	// checks and time ranges compare integers. Old orders hold UTC text from
+	// CURRENT_TIMESTAMP; old session expiries were written in server local time.
+	constexpr char kEpochMillisTimestamps[] = R"SQL(
+	ALTER TABLE orders ADD COLUMN created_at_ms INTEGER NOT NULL DEFAULT 0;
+	ALTER TABLE orders ADD COLUMN updated_at_ms INTEGER NOT NULL DEFAULT 0;
+	UPDATE orders SET
+		created_at_ms = COALESCE(CAST(ROUND((julianday(created_at) - 2440587.5) * 86400000) AS INTEGER), 0),
+		updated_at_ms = COALESCE(CAST(ROUND((julianday(updated_at) - 2440587.5) * 86400000) AS INTEGER), 0);
+	ALTER TABLE orders DROP COLUMN created_at;
+	ALTER TABLE orders DROP COLUMN updated_at;
+	ALTER TABLE orders RENAME COLUMN created_at_ms TO created_at;
+	ALTER TABLE orders RENAME COLUMN updated_at_ms TO updated_at;
+
+	DROP INDEX IF EXISTS idx_sessions_expires_at;
+	ALTER TABLE sessions ADD COLUMN expires_at_ms INTEGER NOT NULL DEFAULT 0;
+	ALTER TABLE sessions ADD COLUMN created_at_ms INTEGER NOT NULL DEFAULT 0;
+	UPDATE sessions SET
+		expires_at_ms = COALESCE(CAST(ROUND((julianday(expires_at, 'utc') - 2440587.5) * 86400000) AS INTEGER), 0),
+		created_at_ms = COALESCE(CAST(ROUND((julianday(created_at) - 2440587.5) * 86400000) AS INTEGER), 0);
+	ALTER TABLE sessions DROP COLUMN expires_at;
+	ALTER TABLE sessions DROP COLUMN created_at;
+	ALTER TABLE sessions RENAME COLUMN expires_at_ms TO expires_at;
+	ALTER TABLE sessions RENAME COLUMN created_at_ms TO created_at;
+	CREATE INDEX idx_sessions_expires_at ON sessions(expires_at);
+)SQL";
+
+	// Sales aggregates keyed by UTC day of order creation, kept up to date by
+	// the order write paths. Backfilled from the orders present right now.
+	constexpr char kSalesAggregates[] = R"SQL(
+	CREATE TABLE IF NOT EXISTS daily_sales (
+		day INTEGER PRIMARY KEY,
+		order_count INTEGER NOT NULL DEFAULT 0,
+		revenue REAL NOT NULL DEFAULT 0,
+		completed_count INTEGER NOT NULL DEFAULT 0,
+		completed_revenue REAL NOT NULL DEFAULT 0
+	);
+	CREATE TABLE IF NOT EXISTS dish_sales (
+		day INTEGER NOT NULL,
+		dish_id INTEGER NOT NULL,
+		quantity INTEGER NOT NULL DEFAULT 0,
+		revenue REAL NOT NULL DEFAULT 0,
+		PRIMARY KEY(day, dish_id)
+	) WITHOUT ROWID;
+	INSERT INTO daily_sales(day, order_count, revenue, completed_count, completed_revenue)
+	SELECT created_at / 86400000, COUNT(*), SUM(total),
+		SUM(status = 'completed'), SUM(CASE WHEN status = 'completed' THEN total ELSE 0 END)
+	FROM orders GROUP BY created_at / 86400000;
+	INSERT INTO dish_sales(day, dish_id, quantity, revenue)
+	SELECT o.created_at / 86400000, i.dish_id, SUM(i.quantity), SUM(i.quantity * i.unit_price)
+	FROM order_items i JOIN orders o ON o.id = i.order_id
+	GROUP BY o.created_at / 86400000, i.dish_id;
+)SQL";
+
+	// Highest order event lsn already applied to the tables above; advanced
+	// in the same transaction as the events themselves.
+	constexpr char kOrderEventLogState[] = R"SQL(
+	CREATE TABLE IF NOT EXISTS event_log_state (
+		id INTEGER PRIMARY KEY CHECK (id = 1),
+		applied_lsn INTEGER NOT NULL
+	);
+	INSERT OR IGNORE INTO event_log_state(id, applied_lsn) VALUES (1, 0);
+)SQL";
+}
+
+const std::vector<Migration>& schemaMigrations() {
+	static const std::vector<Migration> migrations = {
+		{1, "base tables and seed menu", kBaseSchema},
+		{2, "hot path indexes", kHotPathIndexes},
+		{3, "epoch millisecond timestamps", kEpochMillisTimestamps},
+		{4, "sales aggregates", kSalesAggregates},
+		{5, "order event log state", kOrderEventLogState},
+	};
+	return migrations;
+}
+
+int latestSchemaVersion() {
+	return schemaMigrations().back().version;
+}
@@ -0,0 +1,15 @@
+#pragma once
+#include <vector>
+
+// A numbered schema step. Database applies every migration whose version is
+// above PRAGMA user_version, each in its own transaction, and then bumps
+// user_version. Never edit a released migration; append a new one instead.
+struct Migration {
+	int version;
+	const char* description;
+	const char* sql;
+};
+
+// Sorted by version, starting at 1 with no gaps.
+const std::vector<Migration>& schemaMigrations();
+int latestSchemaVersion();
@@ -0,0 +1,438 @@
+#include "OrderEventLog.h"
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+// One mapped segment file. Written only by the appender; the flusher syncs
+// ranges of it.
+class LogSegment {
+public:
+	LogSegment(std::string path, uint64_t firstLsn) : path(std::move(path)), firstLsn(firstLsn) {}
+	~LogSegment() { unmap(); }
+
+	// Maps the file, growing it to minBytes (zero-filled) if it is shorter.
+	bool map(size_t minBytes, std::string& errMsg) {
+#ifdef _WIN32
+		file = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (file == INVALID_HANDLE_VALUE) {
+			errMsg = "cannot open " + path;
+			return false;
+		}
+		LARGE_INTEGER current{};
+		GetFileSizeEx(file, &current);
+		size = std::max(static_cast<size_t>(current.QuadPart), minBytes);
+		if (static_cast<size_t>(current.QuadPart) < size) {
+			LARGE_INTEGER target{};
+			target.QuadPart = static_cast<LONGLONG>(size);
+			if (!SetFilePointerEx(file, target, nullptr, FILE_BEGIN) || !SetEndOfFile(file)) {
+				errMsg = "cannot size " + path;
+				return false;
+			}
+		}
+		mapping = CreateFileMappingA(file, nullptr, PAGE_READWRITE, 0, 0, nullptr);
+		data = mapping ? static_cast<char*>(MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size)) : nullptr;
+#else
+		fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+		if (fd < 0) {
+			errMsg = "cannot open " + path;
+			return false;
+		}
+		struct stat st {};
+		fstat(fd, &st);
+		size = std::max(static_cast<size_t>(st.st_size), minBytes);
+		if (static_cast<size_t>(st.st_size) < size && ftruncate(fd, static_cast<off_t>(size)) != 0) {
+			errMsg = "cannot size " + path;
+			return false;
+		}
+		void* p = size ? mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : MAP_FAILED;
+		data = p == MAP_FAILED ? nullptr : static_cast<char*>(p);
+#endif
+		if (!data) {
+			errMsg = "cannot map " + path;
+			return false;
+		}
+		return true;
+	}
+
+	// Writes [from, to) of the mapping through to disk.
+	bool sync(size_t from, size_t to) {
+		if (to <= from) return true;
+#ifdef _WIN32
+		return FlushViewOfFile(data + from, to - from) && FlushFileBuffers(file);
+#else
+		const size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+		const size_t start = from - from % page;
+		return msync(data + start, to - start, MS_SYNC) == 0;
+#endif
+	}
+
+	void unmap() {
+#ifdef _WIN32
+		if (data) UnmapViewOfFile(data);
+		if (mapping) CloseHandle(mapping);
+		if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+		mapping = nullptr;
+		file = INVALID_HANDLE_VALUE;
+#else
+		if (data) munmap(data, size);
+		if (fd >= 0) ::close(fd);
+		fd = -1;
+#endif
+		data = nullptr;
+	}
+
+	const std::string path;
+	const uint64_t firstLsn;
+	char* data{nullptr};
+	size_t size{0};
+	// End of the last valid record; the appender's write position.
+	size_t writeOffset{0};
+	uint64_t lastLsn{0};
+
+private:
+#ifdef _WIN32
+	HANDLE file{INVALID_HANDLE_VALUE};
+	HANDLE mapping{nullptr};
+#else
+	int fd{-1};
+#endif
+};
+
+namespace {
+	// Record: u32 payload length, u32 CRC-32 of the payload, payload.
+	// Payload: u64 lsn, u8 type, i32 order id, i64 time, then for Created
+	// u8 has user, i32 user id, u32 item count, items (i32, i32, f64); for
+	// StatusChanged u16 length and the status bytes.
+	constexpr size_t kRecordHeaderBytes = 8;
+
+	uint32_t crc32(const char* data, size_t len) {
+		static const auto table = [] {
+			std::array<uint32_t, 256> t{};
+			for (uint32_t i = 0; i < 256; ++i) {
+				uint32_t c = i;
+				for (int k = 0; k < 8; ++k) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+				t[i] = c;
+			}
+			return t;
+		}();
+		uint32_t crc = 0xFFFFFFFFu;
+		for (size_t i = 0; i < len; ++i) {
+			crc = table[(crc ^ static_cast<uint8_t>(data[i])) & 0xFF] ^ (crc >> 8);
+		}
+		return crc ^ 0xFFFFFFFFu;
+	}
+
+	template <typename T>
+	void put(std::string& out, T value) {
+		out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+	}
+
+	template <typename T>
+	bool take(const char*& p, const char* end, T& value) {
+		if (static_cast<size_t>(end - p) < sizeof(value)) return false;
+		std::memcpy(&value, p, sizeof(value));
+		p += sizeof(value);
+		return true;
+	}
+
+	std::string encode(const OrderEvent& event) {
+		std::string out;
+		put(out, event.lsn);
+		put(out, static_cast<uint8_t>(event.type));
+		put(out, static_cast<int32_t>(event.orderId));
+		put(out, static_cast<int64_t>(event.at));
+		if (event.type == OrderEventType::Created) {
+			put(out, static_cast<uint8_t>(event.userId.has_value()));
+			put(out, static_cast<int32_t>(event.userId.value_or(0)));
+			put(out, static_cast<uint32_t>(event.items.size()));
+			for (const auto& item : event.items) {
+				put(out, static_cast<int32_t>(item.dishId));
+				put(out, static_cast<int32_t>(item.quantity));
+				put(out, item.unitPrice);
+			}
+		} else if (event.type == OrderEventType::StatusChanged) {
+			put(out, static_cast<uint16_t>(event.status.size()));
+			out += event.status;
+		}
+		return out;
+	}
+
+	bool decode(const char* p, const char* end, OrderEvent& event) {
+		uint8_t type = 0;
+		int32_t orderId = 0;
+		int64_t at = 0;
+		if (!take(p, end, event.lsn) || !take(p, end, type) || !take(p, end, orderId) || !take(p, end, at)) return false;
+		event.type = static_cast<OrderEventType>(type);
+		event.orderId = orderId;
+		event.at = at;
+		event.userId.reset();
+		event.items.clear();
+		event.status.clear();
+		switch (event.type) {
+		case OrderEventType::Created: {
+			uint8_t hasUser = 0;
+			int32_t userId = 0;
+			uint32_t count = 0;
+			if (!take(p, end, hasUser) || !take(p, end, userId) || !take(p, end, count)) return false;
+			if (hasUser) event.userId = userId;
+			for (uint32_t i = 0; i < count; ++i) {
+				int32_t dishId = 0;
+				int32_t quantity = 0;
+				double unitPrice = 0.0;
+				if (!take(p, end, dishId) || !take(p, end, quantity) || !take(p, end, unitPrice)) return false;
+				event.items.push_back(OrderItem{dishId, quantity, unitPrice});
+			}
+			return p == end;
+		}
+		case OrderEventType::StatusChanged: {
+			uint16_t len = 0;
+			if (!take(p, end, len) || static_cast<size_t>(end - p) != len) return false;
+			event.status.assign(p, len);
+			return true;
+		}
+		case OrderEventType::PickupNotified:
+			return p == end;
+		}
+		return false;
+	}
+
+	// Reads the record at offset. Returns its total size, or 0 at the end of
+	// the written data or at a torn/corrupt record.
+	size_t readRecord(const LogSegment& segment, size_t offset, OrderEvent& event) {
+		if (offset + kRecordHeaderBytes > segment.size) return 0;
+		uint32_t len = 0;
+		uint32_t crc = 0;
+		std::memcpy(&len, segment.data + offset, sizeof(len));
+		std::memcpy(&crc, segment.data + offset + 4, sizeof(crc));
+		if (len == 0 || len > segment.size - offset - kRecordHeaderBytes) return 0;
+		const char* payload = segment.data + offset + kRecordHeaderBytes;
+		if (crc32(payload, len) != crc || !decode(payload, payload + len, event)) return 0;
+		return kRecordHeaderBytes + len;
+	}
+
+	std::string segmentName(uint64_t firstLsn) {
+		char name[48];
+		std::snprintf(name, sizeof(name), "orders-%020llu.log", static_cast<unsigned long long>(firstLsn));
+		return name;
+	}
+}
+
+OrderEventLog::OrderEventLog() = default;
+
+OrderEventLog::~OrderEventLog() {
+	close();
+}
+
+bool OrderEventLog::open(const std::string& path, size_t bytes, std::string& errMsg) {
+	dir = path;
+	segmentBytes = bytes;
+	std::error_code ec;
+	fs::create_directories(dir, ec);
+	if (ec) {
+		errMsg = "cannot create " + dir + ": " + ec.message();
+		return false;
+	}
+
+	std::vector<std::pair<uint64_t, std::string>> files;
+	for (const auto& entry : fs::directory_iterator(dir, ec)) {
+		const std::string name = entry.path().filename().string();
+		unsigned long long first = 0;
+		if (std::sscanf(name.c_str(), "orders-%20llu.log", &first) == 1 && name == segmentName(first)) {
+			files.emplace_back(first, entry.path().string());
+		}
+	}
+	std::sort(files.begin(), files.end());
+
+	uint64_t last = 0;
+	for (size_t i = 0; i < files.size(); ++i) {
+		auto segment = std::make_unique<LogSegment>(files[i].second, files[i].first);
+		// The newest segment is appended to again, so give it full size (it may
+		// be empty if the process died right after creating it).
+		if (!segment->map(i + 1 == files.size() ? segmentBytes : 1, errMsg)) {
+			return false;
+		}
+		OrderEvent event{};
+		size_t offset = 0;
+		while (size_t len = readRecord(*segment, offset, event)) {
+			if (event.lsn <= last) break;
+			last = event.lsn;
+			segment->lastLsn = event.lsn;
+			offset += len;
+		}
+		segment->writeOffset = offset;
+		// Anything after the last good record must be zero, or a later append
+		// could end up followed by stale bytes that look like a record.
+		size_t junk = offset;
+		while (junk < segment->size && segment->data[junk] == 0) ++junk;
+		if (junk < segment->size) {
+			if (i + 1 != files.size()) {
+				errMsg = "order event log segment " + segment->path + " is corrupt at offset " + std::to_string(offset);
+				return false;
+			}
+			printf("Order event log: dropping torn tail of %s at offset %zu\n", segment->path.c_str(), offset);
+			std::memset(segment->data + offset, 0, segment->size - offset);
+			segment->sync(offset, segment->size);
+		}
+		segments.push_back(std::move(segment));
+	}
+
+	nextLsn = last + 1;
+	appendedLsn = last;
+	durableLsn = last;
+	stopping = false;
+	syncFailed = false;
+	flusher = std::thread([this]() { runFlusher(); });
+	return true;
+}
+
+void OrderEventLog::close() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	appended.notify_all();
+	if (flusher.joinable()) {
+		flusher.join();
+	}
+	std::lock_guard<std::mutex> lock(mutex);
+	segments.clear();
+}
+
+void OrderEventLog::forEach(uint64_t afterLsn, const std::function<void(const OrderEvent&)>& fn) const {
+	std::lock_guard<std::mutex> lock(mutex);
+	for (const auto& segment : segments) {
+		if (segment->lastLsn <= afterLsn) continue;
+		OrderEvent event{};
+		size_t offset = 0;
+		while (offset < segment->writeOffset) {
+			const size_t len = readRecord(*segment, offset, event);
+			if (len == 0) break;
+			if (event.lsn > afterLsn) fn(event);
+			offset += len;
+		}
+	}
+}
+
+uint64_t OrderEventLog::lastLsn() const {
+	std::lock_guard<std::mutex> lock(mutex);
+	return nextLsn - 1;
+}
+
+void OrderEventLog::advanceTo(uint64_t lsn) {
+	std::lock_guard<std::mutex> lock(mutex);
+	if (nextLsn <= lsn) {
+		nextLsn = lsn + 1;
+		appendedLsn = std::max(appendedLsn, lsn);
+		durableLsn = std::max(durableLsn, lsn);
+	}
+}
+
+bool OrderEventLog::addSegment(uint64_t firstLsn, std::string& errMsg) {
+	auto segment = std::make_unique<LogSegment>((fs::path(dir) / segmentName(firstLsn)).string(), firstLsn);
+	if (!segment->map(segmentBytes, errMsg)) {
+		return false;
+	}
+	segments.push_back(std::move(segment));
+	return true;
+}
+
+bool OrderEventLog::append(OrderEvent& event, std::string& errMsg) {
+	std::unique_lock<std::mutex> lock(mutex);
+	event.lsn = nextLsn;
+	const std::string payload = encode(event);
+	const size_t recordBytes = kRecordHeaderBytes + payload.size();
+	if (recordBytes > segmentBytes) {
+		errMsg = "order event too large for a log segment";
+		return false;
+	}
+	if (segments.empty() || segments.back()->writeOffset + recordBytes > segments.back()->size) {
+		// Seal the current segment before starting the next, so a torn write
+		// can only ever be in the newest segment.
+		if (!segments.empty() && !segments.back()->sync(0, segments.back()->writeOffset)) {
+			errMsg = "order event log sync failed";
+			return false;
+		}
+		if (!addSegment(event.lsn, errMsg)) {
+			return false;
+		}
+	}
+
+	auto& segment = *segments.back();
+	const uint32_t len = static_cast<uint32_t>(payload.size());
+	const uint32_t crc = crc32(payload.data(), payload.size());
+	char* out = segment.data + segment.writeOffset;
+	std::memcpy(out + kRecordHeaderBytes, payload.data(), payload.size());
+	std::memcpy(out + 4, &crc, sizeof(crc));
+	std::memcpy(out, &len, sizeof(len));
+	segment.writeOffset += recordBytes;
+	segment.lastLsn = event.lsn;
+	appendedLsn = event.lsn;
+	++nextLsn;
+	lock.unlock();
+	appended.notify_one();
+	return true;
+}
+
+bool OrderEventLog::waitDurable(uint64_t lsn) {
+	std::unique_lock<std::mutex> lock(mutex);
+	synced.wait(lock, [&]() { return durableLsn >= lsn || syncFailed; });
+	return durableLsn >= lsn;
+}
+
+void OrderEventLog::releaseThrough(uint64_t lsn) {
+	std::lock_guard<std::mutex> lock(mutex);
+	// A segment is done once the next one starts at or below lsn + 1.
+	while (segments.size() > 1 && segments[1]->firstLsn <= lsn + 1) {
+		const std::string path = segments.front()->path;
+		segments.pop_front();
+		std::error_code ec;
+		fs::remove(path, ec);
+	}
+}
+
+void OrderEventLog::runFlusher() {
+	std::unique_lock<std::mutex> lock(mutex);
+	size_t syncedOffset = 0;
+	uint64_t syncedSegment = 0;
+	while (true) {
+		appended.wait(lock, [&]() { return stopping || appendedLsn > durableLsn; });
+		if (appendedLsn <= durableLsn) {
+			return;
+		}
+		// Everything appended so far goes out in one sync; writers that
+		// arrive meanwhile are picked up by the next round.
+		LogSegment* segment = segments.back().get();
+		if (segment->firstLsn != syncedSegment) {
+			syncedSegment = segment->firstLsn;
+			syncedOffset = 0;
+		}
+		const size_t from = syncedOffset;
+		const size_t to = segment->writeOffset;
+		const uint64_t target = appendedLsn;
+		lock.unlock();
+		const bool ok = segment->sync(from, to);
+		lock.lock();
+		if (!ok) {
+			printf("Order event log sync failed for %s\n", segment->path.c_str());
+			syncFailed = true;
+			synced.notify_all();
+			return;
+		}
+		syncedOffset = to;
+		durableLsn = std::max(durableLsn, target);
+		synced.notify_all();
+	}
+}
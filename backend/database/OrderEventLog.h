@@ -0,0 +1,81 @@
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../models/Order.h"
+
+enum class OrderEventType : uint8_t {
+	Created = 1,
+	StatusChanged = 2,
+	PickupNotified = 3,
+};
+
+// One logged order write. Every event carries the order id and its time;
+// Created adds the user and the priced items, StatusChanged the new status.
+struct OrderEvent {
+	uint64_t lsn;
+	OrderEventType type;
+	int orderId;
+	EpochMillis at;
+	std::optional<int> userId;
+	std::vector<OrderItem> items;
+	std::string status;
+};
+
+class LogSegment;
+
+// Append-only log of order events in fixed-size, memory-mapped segment files
+// ("orders-<first lsn>.log"). Appends are a memcpy into the mapping; a
+// flusher thread syncs whatever has been appended since its last sync, so
+// concurrent writers share one sync. Records are length-prefixed and CRC'd
+// in host byte order; a torn tail is cut off when the log is opened.
+class OrderEventLog {
+public:
+	OrderEventLog();
+	~OrderEventLog();
+	OrderEventLog(const OrderEventLog&) = delete;
+	OrderEventLog& operator=(const OrderEventLog&) = delete;
+
+	bool open(const std::string& dir, size_t segmentBytes, std::string& errMsg);
+	// Syncs what is left and unmaps every segment.
+	void close();
+
+	// Calls fn for every event above afterLsn, oldest first. Startup only.
+	void forEach(uint64_t afterLsn, const std::function<void(const OrderEvent&)>& fn) const;
+	uint64_t lastLsn() const;
+	// Makes the next lsn larger than lsn, e.g. when the log directory was
+	// replaced but the database already applied events up to lsn.
+	void advanceTo(uint64_t lsn);
+
+	// Stamps event.lsn and copies the record into the log; not yet durable.
+	bool append(OrderEvent& event, std::string& errMsg);
+	// Blocks until every event up to lsn is on disk; false if a sync failed.
+	bool waitDurable(uint64_t lsn);
+	// Deletes sealed segments that only hold events at or below lsn.
+	void releaseThrough(uint64_t lsn);
+
+private:
+	void runFlusher();
+	bool addSegment(uint64_t firstLsn, std::string& errMsg);
+
+	std::string dir;
+	size_t segmentBytes{0};
+	std::deque<std::unique_ptr<LogSegment>> segments;
+	uint64_t nextLsn{1};
+	uint64_t appendedLsn{0};
+	uint64_t durableLsn{0};
+	bool syncFailed{false};
+	bool stopping{false};
+	mutable std::mutex mutex;
+	std::condition_variable appended;
+	std::condition_variable synced;
+	std::thread flusher;
+};
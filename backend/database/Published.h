@@ -0,0 +1,51 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+// An immutable value replaced by writers and read from any thread. The C++17
+// std::atomic_load/atomic_store overloads for shared_ptr take a pooled lock
+// on libstdc++ and MSVC, so each reading thread keeps the value it last saw
+// and reloads it only after the version counter moves: a read between
+// writes is one atomic integer load. Writers must be serialized by the
+// caller.
+template <typename T>
+class Published {
+public:
+	Published() : instanceId(nextInstanceId.fetch_add(1, std::memory_order_relaxed)) {}
+	Published(const Published&) = delete;
+	Published& operator=(const Published&) = delete;
+
+	// nullptr until something is stored, or after nullptr is.
+	std::shared_ptr<const T> load() const {
+		// One slot per thread and T; a second instance of the same T only
+		// costs the reloads when a thread alternates between them.
+		thread_local Slot slot;
+		const uint64_t current = version.load(std::memory_order_acquire);
+		if (slot.owner != instanceId || slot.version != current) {
+			slot.value = std::atomic_load(&value);
+			slot.owner = instanceId;
+			slot.version = current;
+		}
+		return slot.value;
+	}
+
+	void store(std::shared_ptr<const T> next) {
+		std::atomic_store(&value, std::move(next));
+		version.fetch_add(1, std::memory_order_release);
+	}
+
+private:
+	struct Slot {
+		uint64_t owner{0};
+		uint64_t version{0};
+		std::shared_ptr<const T> value;
+	};
+
+	static inline std::atomic<uint64_t> nextInstanceId{1};
+
+	const uint64_t instanceId;
+	// Starts above a fresh Slot's version, so the first read always loads.
+	std::atomic<uint64_t> version{1};
+	std::shared_ptr<const T> value;
+};
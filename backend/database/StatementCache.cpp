@@ -0,0 +1,38 @@
+#include "StatementCache.h"
+
+StatementCache::~StatementCache() {
+	clear();
+}
+
+void StatementCache::attach(sqlite3* connection) {
+	clear();
+	db = connection;
+}
+
+void StatementCache::clear() {
+	for (auto& entry : statements) {
+		sqlite3_finalize(entry.second);
+	}
+	statements.clear();
+}
+
+sqlite3_stmt* StatementCache::acquire(const std::string& sql, std::string& errMsg) {
+	const auto it = statements.find(sql);
+	if (it != statements.end()) {
+		++hits;
+		return it->second;
+	}
+	++misses;
+	sqlite3_stmt* stmt = nullptr;
+	if (sqlite3_prepare_v3(db, sql.c_str(), -1, SQLITE_PREPARE_PERSISTENT, &stmt, nullptr) != SQLITE_OK) {
+		errMsg = sqlite3_errmsg(db);
+		sqlite3_finalize(stmt);
+		return nullptr;
+	}
+	statements.emplace(sql, stmt);
+	return stmt;
+}
+
+StatementCacheStats StatementCache::stats() const {
+	return StatementCacheStats{hits, misses, statements.size()};
+}
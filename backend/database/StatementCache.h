@@ -0,0 +1,54 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <sqlite3.h>
+
+struct StatementCacheStats {
+	uint64_t hits;
+	uint64_t misses;
+	size_t size;
+};
+
+// Resets and clears bindings of a cached statement when it goes out of scope,
+// so the next user of the same SQL gets a clean statement.
+class StatementHandle {
+public:
+	explicit StatementHandle(sqlite3_stmt* stmt) : stmt(stmt) {}
+	~StatementHandle() {
+		if (stmt) {
+			sqlite3_reset(stmt);
+			sqlite3_clear_bindings(stmt);
+		}
+	}
+	StatementHandle(const StatementHandle&) = delete;
+	StatementHandle& operator=(const StatementHandle&) = delete;
+
+	operator sqlite3_stmt*() const { return stmt; }
+
+private:
+	sqlite3_stmt* stmt;
+};
+
+// Prepared statements for one connection, keyed by SQL text. Not thread-safe:
+// callers must hold the lock that guards the owning connection.
+class StatementCache {
+public:
+	StatementCache() = default;
+	~StatementCache();
+	StatementCache(const StatementCache&) = delete;
+	StatementCache& operator=(const StatementCache&) = delete;
+
+	void attach(sqlite3* connection);
+	void clear();
+
+	// Returns nullptr and fills errMsg if the statement cannot be prepared.
+	sqlite3_stmt* acquire(const std::string& sql, std::string& errMsg);
+	StatementCacheStats stats() const;
+
+private:
+	sqlite3* db{nullptr};
+	std::unordered_map<std::string, sqlite3_stmt*> statements;
+	uint64_t hits{0};
+	uint64_t misses{0};
+};
@@ -0,0 +1,16 @@
+#include "Storage.h"
+#include <atomic>
+#include "Database.h"
+
+namespace {
+	std::atomic<Storage*> selectedEngine{nullptr};
+}
+
+Storage& Storage::instance() {
+	Storage* engine = selectedEngine.load(std::memory_order_acquire);
+	return engine ? *engine : Database::instance();
+}
+
+void Storage::use(Storage& engine) {
+	selectedEngine.store(&engine, std::memory_order_release);
+}
@@ -0,0 +1,82 @@
+#pragma once
+#include <optional>
+#include <string>
+#include <vector>
+#include "../models/Dish.h"
+#include "../models/Order.h"
+#include "../models/User.h"
+#include "../models/Merchant.h"
+#include "../models/Session.h"
+#include "../models/SalesStats.h"
+
+// Data operations the services need, independent of how they are stored.
+// Database (SQLite) is the production engine; MemoryStorage keeps everything
+// in process so the HTTP and service layers can be measured without disk I/O.
+// Failures set errMsg; "not found" is an empty optional with errMsg untouched.
+class Storage {
+public:
+	// The engine selected with use(); Database::instance() until then.
+	static Storage& instance();
+	// Call once at startup, before any request is served.
+	static void use(Storage& engine);
+
+	virtual ~Storage() = default;
+
+	// Ascending by id.
+	virtual std::vector<Dish> getAllDishes(std::string& errMsg) = 0;
+	// Ascending by id, ids strictly above afterId.
+	virtual std::vector<Dish> getDishesPage(int afterId, int limit, std::string& errMsg) = 0;
+	virtual std::optional<Dish> getDish(int dishId, std::string& errMsg) = 0;
+	virtual std::optional<int> createDish(const Dish& dish, std::string& errMsg) = 0;
+	// Writes all dishes or none: id 0 inserts a new dish, any other id inserts
+	// or replaces that dish. Returns the row count.
+	virtual std::optional<int> upsertDishes(const std::vector<Dish>& dishes, std::string& errMsg) = 0;
+	// Only the given fields change; an unknown id is not an error.
+	virtual bool updateDish(int dishId,
+		const std::optional<std::string>& name,
+		const std::optional<std::string>& description,
+		const std::optional<std::string>& category,
+		const std::optional<double>& price,
+		const std::optional<bool>& isAvailable,
+		std::string& errMsg) = 0;
+
+	// User & merchant management; usernames are unique.
+	virtual bool createUser(const std::string& username, const std::string& passwordHash, const std::string& phone, std::string& errMsg) = 0;
+	virtual bool createMerchant(const std::string& username, const std::string& passwordHash, const std::string& storeName, std::string& errMsg) = 0;
+	virtual std::optional<User> getUserByUsername(const std::string& username, std::string& errMsg) = 0;
+	virtual std::optional<Merchant> getMerchantByUsername(const std::string& username, std::string& errMsg) = 0;
+	virtual std::optional<User> getUserById(int id, std::string& errMsg) = 0;
+	virtual std::optional<Merchant> getMerchantById(int id, std::string& errMsg) = 0;
+
+	// Session tokens; expired sessions are never returned.
+	virtual bool createSessionToken(const std::string& token, const std::optional<int>& userId, const std::optional<int>& merchantId, EpochMillis expiresAt, std::string& errMsg) = 0;
+	virtual std::optional<Session> getSessionByToken(const std::string& token, std::string& errMsg) = 0;
+	// Deletes up to batchSize expired sessions; returns the count.
+	virtual std::optional<int> deleteExpiredSessions(int batchSize, std::string& errMsg) = 0;
+
+	// Prices the items from the menu and returns the new order id; fails if
+	// items is empty or a dish is unknown or unavailable.
+	virtual std::optional<int> createOrder(const std::vector<OrderItem>& items, const std::optional<int>& userId, std::string& errMsg) = 0;
+	virtual std::optional<Order> getOrder(int orderId, std::string& errMsg) = 0;
+	// Listings are newest first. includeArchived also returns archived orders
+	// on engines that archive.
+	virtual std::vector<Order> getAllOrders(std::string& errMsg, bool includeArchived = false) = 0;
+	virtual std::vector<Order> getOrdersByUser(int userId, std::string& errMsg, bool includeArchived = false) = 0;
+	// Orders not yet completed, or completed without pickup acknowledgement.
+	virtual std::vector<Order> getActiveOrders(std::string& errMsg) = 0;
+	// Ids strictly below beforeId (no cursor = from the newest), at most limit.
+	virtual std::vector<Order> getAllOrdersPage(const std::optional<int>& beforeId, int limit, std::string& errMsg, bool includeArchived = false) = 0;
+	virtual std::vector<Order> getOrdersByUserPage(int userId, const std::optional<int>& beforeId, int limit, std::string& errMsg, bool includeArchived = false) = 0;
+	// Order writes only change live orders. An unknown or archived id is not
+	// an error; callers re-read to report it (getOrder sets Order::archived).
+	virtual bool updateOrderStatus(int orderId, const std::string& status, std::string& errMsg) = 0;
+	// Applies all updates together and returns each order as it is
+	// afterwards, in request order; nullopt marks an unknown id and an
+	// archived order comes back unchanged. Neither fails the batch.
+	virtual std::optional<std::vector<std::optional<Order>>> updateOrderStatuses(const std::vector<OrderStatusUpdate>& updates, std::string& errMsg) = 0;
+	virtual bool markOrderPickupNotified(int orderId, std::string& errMsg) = 0;
+
+	// Per-day totals and per-dish sums for the inclusive UTC day range, by
+	// order creation day. Days without orders are omitted.
+	virtual SalesReport getSalesReport(EpochDay fromDay, EpochDay toDay, std::string& errMsg) = 0;
+};
@@ -1,5 +1,7 @@
 // Minimal HTTP server for restaurant-order-system backend
 // Uses cpp-httplib (header-only). For now returns in-memory menu and simple order creation.
+#include <filesystem>
+#include <memory>
 #include <string>
 #include <nlohmann/json.hpp>
 #include "config.h"
@@ -8,45 +10,134 @@
 #include "controllers/OrderController.h"
 #include "controllers/AdminController.h"
 #include "controllers/AuthController.h"
+#include "controllers/WorkerPool.h"
 #include "services/MenuService.h"
 #include "services/OrderService.h"
 #include "services/AuthService.h"
+#include "services/BackupService.h"
+#include "services/OrderEventHub.h"
+#include "services/ResponseCompression.h"
+#include "services/PeriodicTask.h"
+#include "services/SessionSweeper.h"
 #include "database/Database.h"
+#include "database/MemoryStorage.h"
 #include "models/Dish.h"
 #include "models/Order.h"
 using json = nlohmann::json;
 
-
+namespace {
+	// Opens SQLite with the optional event log, group commit and archive. The
+	// archive is only attached when archiving is on or an earlier run left one,
+	// so deployments that never archive do not pay for it on every connection.
+	bool openSqliteStorage(const std::string& dbPath, int archiveAfterDays, std::string& dbErr) {
+		printf("Opening database at: %s\n", dbPath.c_str());
+		if (!Database::instance().open(dbPath, dbErr, get_db_reader_pool_size())) {
+			printf("Failed to open DB at %s: %s\n", dbPath.c_str(), dbErr.c_str());
+			return false;
+		}
+		printf("Database opened and initialized successfully\n");
+		const std::string eventLogDir = get_order_event_log_dir();
+		if (!eventLogDir.empty()) {
+			const size_t segmentBytes = static_cast<size_t>(get_order_event_log_segment_mb()) * 1024 * 1024;
+			if (!Database::instance().enableEventLog(eventLogDir, segmentBytes, dbErr)) {
+				printf("Failed to open order event log at %s: %s\n", eventLogDir.c_str(), dbErr.c_str());
+				return false;
+			}
+			printf("Order event log enabled at %s\n", eventLogDir.c_str());
+		}
+		const int groupCommitBatch = get_order_group_commit_max_batch();
+		if (groupCommitBatch > 1 && eventLogDir.empty()) {
+			Database::instance().enableGroupCommit(static_cast<size_t>(groupCommitBatch), get_order_group_commit_max_wait_us());
+			printf("Order group commit enabled (max batch %d, max wait %dus)\n", groupCommitBatch, get_order_group_commit_max_wait_us());
+		}
+		const std::string archivePath = get_archive_db_path(dbPath);
+		std::error_code ec;
+		if (archiveAfterDays <= 0 && !std::filesystem::exists(archivePath, ec)) {
+			return true;
+		}
+		if (!Database::instance().attachArchive(archivePath, dbErr)) {
+			printf("Failed to attach archive DB at %s: %s\n", archivePath.c_str(), dbErr.c_str());
+			return false;
+		}
+		return true;
+	}
+}
 
 int main() {
 	httplib::Server server;
 
-	// Open database
 	const char* dbPathEnv = std::getenv("DB_PATH");
 	const std::string dbPath = dbPathEnv ? std::string(dbPathEnv) : std::string("restaurant.db");
-	printf("Opening database at: %s\n", dbPath.c_str());
+	const std::string engine = get_storage_engine();
+	const bool inMemory = engine == "memory";
+	const int archiveAfterDays = get_archive_after_days();
+	std::unique_ptr<MemoryStorage> memoryStorage;
 	std::string dbErr;
-	if (!Database::instance().open(dbPath, dbErr)) {
-		printf("Failed to open DB at %s: %s\n", dbPath.c_str(), dbErr.c_str());
+	if (inMemory) {
+		memoryStorage = std::make_unique<MemoryStorage>();
+		Storage::use(*memoryStorage);
+		printf("Using in-memory storage; nothing is persisted\n");
+	} else if (engine != "sqlite") {
+		printf("Unknown STORAGE_ENGINE %s (expected sqlite or memory)\n", engine.c_str());
 		return 1;
+	} else if (!openSqliteStorage(dbPath, archiveAfterDays, dbErr)) {
+		return 1;
+	}
+	PeriodicTask archiver("order-archive", std::chrono::minutes(get_archive_interval_minutes()), [archiveAfterDays]() {
+		std::string err;
+		auto moved = Database::instance().archiveCompletedOrders(archiveAfterDays, 500, err);
+		if (!moved.has_value()) {
+			printf("Order archiving failed: %s\n", err.c_str());
+		} else if (moved.value() > 0) {
+			printf("Archived %d completed orders\n", moved.value());
+		}
+	});
+	if (!inMemory && archiveAfterDays > 0) {
+		archiver.start();
+		archiver.trigger();
 	}
-	printf("Database opened and initialized successfully\n");
+	SessionSweeper sessionSweeper(std::chrono::seconds(get_session_sweep_interval_seconds()), get_session_sweep_batch_size());
+	sessionSweeper.start();
+	const std::string backupPath = get_backup_path(dbPath);
+	BackupService backupService(backupPath, get_archive_backup_path(backupPath), std::chrono::minutes(get_backup_interval_minutes()),
+		get_backup_pages_per_step(), std::chrono::milliseconds(get_backup_step_pause_ms()));
+	if (!inMemory) {
+		backupService.start();
+	}
+	OrderEventHub orderEvents(static_cast<size_t>(get_sse_max_subscribers()), std::chrono::seconds(get_sse_heartbeat_seconds()));
 
 	server.Get("/health", [&](const httplib::Request&, httplib::Response& res) {
 		json j;
 		j["status"] = "ok";
 		j["service"] = "restaurant-backend";
+		const auto cache = Database::instance().statementCacheStats();
+		j["statementCache"] = {{"hits", cache.hits}, {"misses", cache.misses}, {"size", cache.size}};
+		j["orderEvents"] = {{"subscribers", orderEvents.subscriberCount()}};
+		const auto sweep = sessionSweeper.stats();
+		j["sessionSweeper"] = {
+			{"runs", sweep.runs},
+			{"rowsRemoved", sweep.rowsRemoved},
+			{"lastRunRowsRemoved", sweep.lastRunRowsRemoved},
+			{"lastBatchMicros", sweep.lastBatchMicros},
+			{"maxBatchMicros", sweep.maxBatchMicros}
+		};
 		res.set_content(j.dump(), "application/json");
 	});
 
+	setCompressionMinBytes(static_cast<size_t>(get_compression_min_bytes()));
+
 	// Register routes via controllers/services
 	MenuService menuService;
-	OrderService orderService;
+	OrderService orderService(orderEvents);
 	AuthService authService;
+	if (!orderService.loadActiveOrders(dbErr)) {
+		printf("Failed to load active orders: %s\n", dbErr.c_str());
+		return 1;
+	}
 	registerAuthRoutes(server, authService);
 	registerMenuRoutes(server, menuService);
-	registerOrderRoutes(server, orderService, authService);
-	registerAdminRoutes(server, orderService, menuService, authService);
+	registerOrderRoutes(server, orderService, authService, orderEvents);
+	registerAdminRoutes(server, orderService, menuService, authService, backupService);
 
 	// 404 handler
 	server.set_error_handler([](const httplib::Request& req, httplib::Response& res) {
@@ -57,6 +148,11 @@ int main() {
 		res.set_content(j.dump(), "application/json");
 	});
 
+	// Every open order event stream keeps a thread; the pool starts those on
+	// demand, so ordinary requests keep the default worker count.
+	const size_t maxStreams = static_cast<size_t>(get_sse_max_subscribers());
+	server.new_task_queue = [maxStreams]() { return new WorkerPool(CPPHTTPLIB_THREAD_POOL_COUNT, maxStreams); };
+
 	// Config
 	const auto host = get_server_host();
 	const int port = get_server_port();
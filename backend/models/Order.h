@@ -2,6 +2,7 @@
 #include <vector>
 #include <string>
 #include <optional>
+#include "Timestamp.h"
 
 struct OrderItem {
 	int dishId;
@@ -9,6 +10,11 @@ struct OrderItem {
 	double unitPrice;
 };
 
+struct OrderStatusUpdate {
+	int orderId;
+	std::string status;
+};
+
 struct Order {
 	int id;
 	std::optional<int> userId;
@@ -16,8 +22,10 @@ struct Order {
 	std::string status;
 	double total;
 	bool pickupNotified;
-	std::string createdAt;
-	std::string updatedAt;
+	EpochMillis createdAt;
+	EpochMillis updatedAt;
+	// Read from the archive database; archived orders no longer change.
+	bool archived{false};
 };
 
 
@@ -0,0 +1,27 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "Timestamp.h"
+
+// One row of the daily_sales aggregate, keyed by the orders' creation day.
+struct DailySales {
+	EpochDay day;
+	int orderCount;
+	double revenue;
+	int completedCount;
+	double completedRevenue;
+};
+
+// dish_sales summed over a day range.
+struct DishSales {
+	int dishId;
+	std::string name;
+	int quantity;
+	double revenue;
+};
+
+struct SalesReport {
+	std::vector<DailySales> days;
+	// Best sellers first.
+	std::vector<DishSales> dishes;
+};
@@ -1,14 +1,15 @@
 #pragma once
 #include <string>
 #include <optional>
+#include "Timestamp.h"
 
 struct Session {
 	int id;
 	std::string token;
 	std::optional<int> userId;
 	std::optional<int> merchantId;
-	std::string expiresAt;
-	std::string createdAt;
+	EpochMillis expiresAt;
+	EpochMillis createdAt;
 };
 
 
@@ -0,0 +1,66 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+#include <optional>
+#include <cstdio>
+#include <string>
+
+// Timestamps are stored and passed around as UTC milliseconds since the Unix
+// epoch; they are only turned into text when a response is serialized.
+using EpochMillis = std::int64_t;
+// Whole UTC days since 1970-01-01; the key of the daily sales aggregates.
+using EpochDay = std::int64_t;
+
+constexpr EpochMillis kMillisPerDay = 24LL * 60 * 60 * 1000;
+
+inline EpochMillis nowEpochMillis() {
+	using namespace std::chrono;
+	return duration_cast<milliseconds>(system_clock::now().time_since_epoch()).count();
+}
+
+// "YYYY-MM-DD HH:MM:SS" in UTC, the format the API returned when timestamps
+// were SQLite TEXT columns.
+inline std::string formatEpochMillis(EpochMillis millis) {
+	std::time_t t = static_cast<std::time_t>(millis / 1000);
+	std::tm tm{};
+#ifdef _WIN32
+	gmtime_s(&tm, &t);
+#else
+	gmtime_r(&t, &tm);
+#endif
+	char buf[20];
+	std::strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M:%S", &tm);
+	return buf;
+}
+
+inline EpochDay epochDayOf(EpochMillis millis) {
+	return millis >= 0 ? millis / kMillisPerDay : (millis - kMillisPerDay + 1) / kMillisPerDay;
+}
+
+// Parses "YYYY-MM-DD" (proleptic Gregorian calendar, days_from_civil).
+inline std::optional<EpochDay> parseEpochDay(const std::string& text) {
+	int y = 0;
+	unsigned m = 0;
+	unsigned d = 0;
+	char tail = 0;
+	if (text.size() != 10 || std::sscanf(text.c_str(), "%4d-%2u-%2u%c", &y, &m, &d, &tail) != 3) {
+		return std::nullopt;
+	}
+	static const unsigned kDaysInMonth[] = {31, 29, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+	const bool leap = (y % 4 == 0 && y % 100 != 0) || y % 400 == 0;
+	if (m < 1 || m > 12 || d < 1 || d > kDaysInMonth[m - 1] || (m == 2 && d == 29 && !leap)) {
+		return std::nullopt;
+	}
+	y -= m <= 2;
+	const int era = (y >= 0 ? y : y - 399) / 400;
+	const unsigned yoe = static_cast<unsigned>(y - era * 400);
+	const unsigned doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+	const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+	return static_cast<EpochDay>(era) * 146097 + static_cast<EpochDay>(doe) - 719468;
+}
+
+// "YYYY-MM-DD" for a day produced by epochDayOf or parseEpochDay.
+inline std::string formatEpochDay(EpochDay day) {
+	return formatEpochMillis(day * kMillisPerDay).substr(0, 10);
+}
@@ -0,0 +1,104 @@
+#include "ActiveOrderStore.h"
+#include <mutex>
+
+bool ActiveOrderStore::isActive(const Order& order) {
+	return order.status != "completed" || !order.pickupNotified;
+}
+
+void ActiveOrderStore::rebuild(const std::vector<Order>& orders) {
+	std::unique_lock<std::shared_mutex> lock(mutex);
+	byId.clear();
+	byUser.clear();
+	byStatus.clear();
+	for (const auto& order : orders) {
+		if (isActive(order)) {
+			insertLocked(order);
+		}
+	}
+}
+
+void ActiveOrderStore::apply(const Order& order) {
+	std::unique_lock<std::shared_mutex> lock(mutex);
+	eraseLocked(order.id);
+	if (isActive(order)) {
+		insertLocked(order);
+	}
+}
+
+void ActiveOrderStore::insertIfAbsent(const Order& order) {
+	std::unique_lock<std::shared_mutex> lock(mutex);
+	if (byId.count(order.id) == 0 && isActive(order)) {
+		insertLocked(order);
+	}
+}
+
+void ActiveOrderStore::remove(int id) {
+	std::unique_lock<std::shared_mutex> lock(mutex);
+	eraseLocked(id);
+}
+
+std::optional<Order> ActiveOrderStore::get(int id) const {
+	std::shared_lock<std::shared_mutex> lock(mutex);
+	const auto it = byId.find(id);
+	if (it == byId.end()) return std::nullopt;
+	return it->second;
+}
+
+std::vector<Order> ActiveOrderStore::list(const std::optional<std::string>& status) const {
+	std::shared_lock<std::shared_mutex> lock(mutex);
+	std::vector<Order> result;
+	if (!status.has_value()) {
+		result.reserve(byId.size());
+		for (const auto& entry : byId) {
+			result.push_back(entry.second);
+		}
+		return result;
+	}
+	const auto ids = byStatus.find(status.value());
+	if (ids == byStatus.end()) return result;
+	result.reserve(ids->second.size());
+	for (int id : ids->second) {
+		result.push_back(byId.at(id));
+	}
+	return result;
+}
+
+std::vector<Order> ActiveOrderStore::listByUser(int userId) const {
+	std::shared_lock<std::shared_mutex> lock(mutex);
+	std::vector<Order> result;
+	const auto ids = byUser.find(userId);
+	if (ids == byUser.end()) return result;
+	result.reserve(ids->second.size());
+	for (int id : ids->second) {
+		result.push_back(byId.at(id));
+	}
+	return result;
+}
+
+size_t ActiveOrderStore::size() const {
+	std::shared_lock<std::shared_mutex> lock(mutex);
+	return byId.size();
+}
+
+void ActiveOrderStore::insertLocked(const Order& order) {
+	byId[order.id] = order;
+	if (order.userId.has_value()) {
+		byUser[order.userId.value()].insert(order.id);
+	}
+	byStatus[order.status].insert(order.id);
+}
+
+void ActiveOrderStore::eraseLocked(int id) {
+	const auto it = byId.find(id);
+	if (it == byId.end()) return;
+	const Order& order = it->second;
+	if (order.userId.has_value()) {
+		auto user = byUser.find(order.userId.value());
+		user->second.erase(id);
+		if (user->second.empty()) byUser.erase(user);
+	}
+	auto status = byStatus.find(order.status);
+	status->second.erase(id);
+	if (status->second.empty()) byStatus.erase(status);
+	byId.erase(it);
+}
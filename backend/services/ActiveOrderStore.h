@@ -0,0 +1,42 @@
+#pragma once
+#include <functional>
+#include <map>
+#include <optional>
+#include <set>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "../models/Order.h"
+
+// In-memory copy of every order that is still in flight: pending, preparing,
+// ready, or completed but not yet acknowledged by the customer. SQLite stays
+// the source of truth; OrderService writes through and mirrors the result here.
+class ActiveOrderStore {
+public:
+	static bool isActive(const Order& order);
+
+	void rebuild(const std::vector<Order>& orders);
+	// Stores the order if it is active and drops it otherwise.
+	void apply(const Order& order);
+	// Used right after creation so a concurrent, newer update is not overwritten.
+	void insertIfAbsent(const Order& order);
+	void remove(int id);
+
+	std::optional<Order> get(int id) const;
+	// Newest first.
+	std::vector<Order> list(const std::optional<std::string>& status) const;
+	std::vector<Order> listByUser(int userId) const;
+	size_t size() const;
+
+private:
+	using IdSet = std::set<int, std::greater<int>>;
+
+	void insertLocked(const Order& order);
+	void eraseLocked(int id);
+
+	mutable std::shared_mutex mutex;
+	std::map<int, Order, std::greater<int>> byId;
+	std::unordered_map<int, IdSet> byUser;
+	std::unordered_map<std::string, IdSet> byStatus;
+};
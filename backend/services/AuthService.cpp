@@ -1,12 +1,9 @@
 #include "AuthService.h"
-#include <chrono>
 #include <cctype>
-#include <ctime>
-#include <iomanip>
 #include <optional>
 #include <random>
 #include <sstream>
-#include "../database/Database.h"
+#include "../database/Storage.h"
 
 namespace {
 	constexpr char kPepper[] = "restaurant-order-system-pepper";
@@ -28,7 +25,7 @@ bool AuthService::registerUser(const std::string& username, const std::string& p
 		errMsg = "密码至少 6 位";
 		return false;
 	}
-	auto existing = Database::instance().getUserByUsername(username, errMsg);
+	auto existing = Storage::instance().getUserByUsername(username, errMsg);
 	if (!errMsg.empty()) {
 		return false;
 	}
@@ -37,7 +34,7 @@ bool AuthService::registerUser(const std::string& username, const std::string& p
 		return false;
 	}
 	const auto hash = hashPassword(password);
-	return Database::instance().createUser(username, hash, phone, errMsg);
+	return Storage::instance().createUser(username, hash, phone, errMsg);
 }
 
 bool AuthService::registerMerchant(const std::string& username, const std::string& password, const std::string& storeName, std::string& errMsg) {
@@ -45,7 +42,7 @@ bool AuthService::registerMerchant(const std::string& username, const std::strin
 		errMsg = "商家账号和密码不能为空，且密码至少 6 位";
 		return false;
 	}
-	auto existing = Database::instance().getMerchantByUsername(username, errMsg);
+	auto existing = Storage::instance().getMerchantByUsername(username, errMsg);
 	if (!errMsg.empty()) {
 		return false;
 	}
@@ -54,11 +51,11 @@ bool AuthService::registerMerchant(const std::string& username, const std::strin
 		return false;
 	}
 	const auto hash = hashPassword(password);
-	return Database::instance().createMerchant(username, hash, storeName, errMsg);
+	return Storage::instance().createMerchant(username, hash, storeName, errMsg);
 }
 
 std::optional<AuthToken> AuthService::loginUser(const std::string& username, const std::string& password, std::string& errMsg) {
-	auto user = Database::instance().getUserByUsername(username, errMsg);
+	auto user = Storage::instance().getUserByUsername(username, errMsg);
 	if (!user.has_value()) {
 		if (errMsg.empty()) errMsg = "用户不存在";
 		return std::nullopt;
@@ -68,15 +65,15 @@ std::optional<AuthToken> AuthService::loginUser(const std::string& username, con
 		return std::nullopt;
 	}
 	const auto token = generateToken();
-	const auto expiry = buildExpiryString(kTokenHours);
-	if (!Database::instance().createSessionToken(token, user->id, std::nullopt, expiry, errMsg)) {
+	const auto expiry = expiryFromNow(kTokenHours);
+	if (!Storage::instance().createSessionToken(token, user->id, std::nullopt, expiry, errMsg)) {
 		return std::nullopt;
 	}
 	return AuthToken{token, user->id};
 }
 
 std::optional<AuthToken> AuthService::loginMerchant(const std::string& username, const std::string& password, std::string& errMsg) {
-	auto merchant = Database::instance().getMerchantByUsername(username, errMsg);
+	auto merchant = Storage::instance().getMerchantByUsername(username, errMsg);
 	if (!merchant.has_value()) {
 		if (errMsg.empty()) errMsg = "商家不存在";
 		return std::nullopt;
@@ -86,29 +83,29 @@ std::optional<AuthToken> AuthService::loginMerchant(const std::string& username,
 		return std::nullopt;
 	}
 	const auto token = generateToken();
-	const auto expiry = buildExpiryString(kTokenHours);
-	if (!Database::instance().createSessionToken(token, std::nullopt, merchant->id, expiry, errMsg)) {
+	const auto expiry = expiryFromNow(kTokenHours);
+	if (!Storage::instance().createSessionToken(token, std::nullopt, merchant->id, expiry, errMsg)) {
 		return std::nullopt;
 	}
 	return AuthToken{token, merchant->id};
 }
 
 std::optional<User> AuthService::authenticateUser(const std::string& token, std::string& errMsg) {
-	auto session = Database::instance().getSessionByToken(token, errMsg);
+	auto session = Storage::instance().getSessionByToken(token, errMsg);
 	if (!session.has_value() || !session->userId.has_value()) {
 		if (errMsg.empty()) errMsg = "会话无效";
 		return std::nullopt;
 	}
-	return Database::instance().getUserById(session->userId.value(), errMsg);
+	return Storage::instance().getUserById(session->userId.value(), errMsg);
 }
 
 std::optional<Merchant> AuthService::authenticateMerchant(const std::string& token, std::string& errMsg) {
-	auto session = Database::instance().getSessionByToken(token, errMsg);
+	auto session = Storage::instance().getSessionByToken(token, errMsg);
 	if (!session.has_value() || !session->merchantId.has_value()) {
 		if (errMsg.empty()) errMsg = "会话无效";
 		return std::nullopt;
 	}
-	return Database::instance().getMerchantById(session->merchantId.value(), errMsg);
+	return Storage::instance().getMerchantById(session->merchantId.value(), errMsg);
 }
 
 bool AuthService::isValidUserAccount(const std::string& username) {
@@ -144,20 +141,8 @@ std::string AuthService::generateToken() {
 	return ss.str();
 }
 
-std::string AuthService::buildExpiryString(int hoursAhead) {
-	using namespace std::chrono;
-	const auto now = system_clock::now();
-	const auto target = now + hours(hoursAhead);
-	std::time_t t = system_clock::to_time_t(target);
-	std::tm tm{};
-#ifdef _WIN32
-	localtime_s(&tm, &t);
-#else
-	localtime_r(&t, &tm);
-#endif
-	std::stringstream ss;
-	ss << std::put_time(&tm, "%Y-%m-%d %H:%M:%S");
-	return ss.str();
+EpochMillis AuthService::expiryFromNow(int hoursAhead) {
+	return nowEpochMillis() + static_cast<EpochMillis>(hoursAhead) * 60 * 60 * 1000;
 }
 
 
@@ -3,6 +3,7 @@
 #include <string>
 #include "../models/User.h"
 #include "../models/Merchant.h"
+#include "../models/Timestamp.h"
 
 struct AuthToken {
 	std::string token;
@@ -25,7 +26,7 @@ private:
 	static std::string hashPassword(const std::string& value);
 	static bool verifyPassword(const std::string& password, const std::string& hash);
 	static std::string generateToken();
-	static std::string buildExpiryString(int hoursAhead);
+	static EpochMillis expiryFromNow(int hoursAhead);
 };
 
 
@@ -0,0 +1,86 @@
+#include "BackupService.h"
+#include <cstdio>
+#include "../database/Database.h"
+
+BackupService::BackupService(std::string path, std::string archivePath, std::chrono::minutes interval, int pagesPerStep, std::chrono::milliseconds stepPause)
+	: path(std::move(path)), archivePath(std::move(archivePath)), pagesPerStep(pagesPerStep), stepPause(stepPause),
+	  current{false, this->path, "", 0, 0, 0, 0, false, ""},
+	  task("backup", interval, [this]() { run(); }) {}
+
+void BackupService::start() {
+	task.start();
+}
+
+void BackupService::stop() {
+	task.stop();
+}
+
+bool BackupService::trigger() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (current.running) return false;
+		// Marked here so a second trigger before the thread wakes is refused too.
+		markStartedLocked();
+	}
+	task.trigger();
+	return true;
+}
+
+BackupStatus BackupService::status() const {
+	std::lock_guard<std::mutex> lock(mutex);
+	return current;
+}
+
+void BackupService::markStartedLocked() {
+	current.running = true;
+	current.startedAt = nowEpochMillis();
+	current.finishedAt = 0;
+	current.pagesTotal = 0;
+	current.pagesRemaining = 0;
+}
+
+void BackupService::run() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (!current.running) {
+			// Scheduled run rather than trigger().
+			markStartedLocked();
+		}
+	}
+
+	// Main first: an order archived between the two copies is then in both
+	// rather than in neither.
+	std::string err;
+	const bool withArchive = Database::instance().isArchiveAttached();
+	const bool ok = copySchema("main", path, err) && (!withArchive || copySchema("archive", archivePath, err));
+
+	std::lock_guard<std::mutex> lock(mutex);
+	current.running = false;
+	current.finishedAt = nowEpochMillis();
+	current.lastSucceeded = ok;
+	current.lastError = ok ? "" : err;
+	current.archivePath = withArchive ? archivePath : "";
+	if (!ok) {
+		printf("Backup failed: %s\n", err.c_str());
+	}
+}
+
+bool BackupService::copySchema(const char* schema, const std::string& destPath, std::string& errMsg) {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		current.pagesTotal = 0;
+		current.pagesRemaining = 0;
+	}
+	const bool ok = Database::instance().backupTo(schema, destPath, pagesPerStep, stepPause, [this](int remaining, int total) {
+		std::lock_guard<std::mutex> lock(mutex);
+		current.pagesRemaining = remaining;
+		current.pagesTotal = total;
+	}, errMsg);
+	if (!ok) {
+		errMsg = std::string(schema) + ": " + errMsg;
+		return false;
+	}
+	std::lock_guard<std::mutex> lock(mutex);
+	printf("Backup written to %s (%d pages)\n", destPath.c_str(), current.pagesTotal);
+	return true;
+}
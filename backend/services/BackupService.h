@@ -0,0 +1,50 @@
+#pragma once
+#include <chrono>
+#include <mutex>
+#include <string>
+#include "PeriodicTask.h"
+#include "../models/Timestamp.h"
+
+struct BackupStatus {
+	bool running;
+	std::string path;
+	// Where the archive database is copied; empty if the last backup had no
+	// archive attached.
+	std::string archivePath;
+	int pagesTotal;
+	int pagesRemaining;
+	// Of the running backup, or of the last one when idle; 0 if none yet.
+	EpochMillis startedAt;
+	EpochMillis finishedAt;
+	bool lastSucceeded;
+	std::string lastError;
+};
+
+// Scheduled and on-demand online backups of the main database and, when it is
+// attached, the order archive. Backups run on the service's own thread, one
+// at a time.
+class BackupService {
+public:
+	// An interval of zero disables the schedule; trigger() still works.
+	BackupService(std::string path, std::string archivePath, std::chrono::minutes interval, int pagesPerStep, std::chrono::milliseconds stepPause);
+
+	void start();
+	void stop();
+	// Starts a backup now; false if one is already running.
+	bool trigger();
+	BackupStatus status() const;
+
+private:
+	void run();
+	// Resets the progress fields for a new backup; caller holds mutex.
+	void markStartedLocked();
+	bool copySchema(const char* schema, const std::string& destPath, std::string& errMsg);
+
+	const std::string path;
+	const std::string archivePath;
+	const int pagesPerStep;
+	const std::chrono::milliseconds stepPause;
+	mutable std::mutex mutex;
+	BackupStatus current;
+	PeriodicTask task;
+};
@@ -0,0 +1,15 @@
+#include "JsonValues.h"
+#include <cstdint>
+#include <limits>
+
+std::optional<int> jsonIntValue(const nlohmann::json& value) {
+	if (value.is_number_unsigned()) {
+		const auto v = value.get<std::uint64_t>();
+		if (v > static_cast<std::uint64_t>(std::numeric_limits<int>::max())) return std::nullopt;
+		return static_cast<int>(v);
+	}
+	if (!value.is_number_integer()) return std::nullopt;
+	const auto v = value.get<std::int64_t>();
+	if (v < std::numeric_limits<int>::min() || v > std::numeric_limits<int>::max()) return std::nullopt;
+	return static_cast<int>(v);
+}
@@ -0,0 +1,6 @@
+#pragma once
+#include <optional>
+#include <nlohmann/json.hpp>
+
+// A JSON integer that fits an int; get<int>() would silently wrap larger ones.
+std::optional<int> jsonIntValue(const nlohmann::json& value);
@@ -0,0 +1,220 @@
+#include "MenuSearchIndex.h"
+#include <algorithm>
+#include <mutex>
+
+namespace {
+	// Bigrams pack two code points (21 bits each); unigrams set the top bit.
+	constexpr uint64_t kUnigramFlag = 1ull << 63;
+
+	uint64_t unigram(char32_t c) {
+		return kUnigramFlag | c;
+	}
+
+	uint64_t bigram(char32_t a, char32_t b) {
+		return (static_cast<uint64_t>(a) << 21) | b;
+	}
+
+	bool isSpace(char32_t c) {
+		return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == 0x3000;
+	}
+
+	// Decodes UTF-8, folding full-width ASCII (U+FF01..U+FF5E) and the
+	// ideographic space to half-width, then ASCII to lower case. Malformed
+	// bytes become U+FFFD.
+	std::u32string fold(const std::string& text) {
+		std::u32string out;
+		out.reserve(text.size());
+		size_t i = 0;
+		while (i < text.size()) {
+			const unsigned char lead = static_cast<unsigned char>(text[i]);
+			size_t length = lead < 0x80 ? 1 : (lead >> 5) == 0x6 ? 2 : (lead >> 4) == 0xE ? 3 : (lead >> 3) == 0x1E ? 4 : 0;
+			char32_t c = 0xFFFD;
+			if (length == 1) {
+				c = lead;
+			} else if (length > 1 && i + length <= text.size()) {
+				c = lead & (0x7F >> length);
+				for (size_t k = 1; k < length; ++k) {
+					const unsigned char next = static_cast<unsigned char>(text[i + k]);
+					if ((next & 0xC0) != 0x80) {
+						c = 0xFFFD;
+						length = k;
+						break;
+					}
+					c = (c << 6) | (next & 0x3F);
+				}
+			} else {
+				length = 1;
+			}
+			i += length;
+			if (c >= 0xFF01 && c <= 0xFF5E) {
+				c -= 0xFEE0;
+			} else if (c == 0x3000) {
+				c = ' ';
+			}
+			if (c >= 'A' && c <= 'Z') {
+				c += 'a' - 'A';
+			}
+			out += c;
+		}
+		return out;
+	}
+
+	// Unigrams and bigrams of text; bigrams do not span whitespace.
+	void addGrams(const std::u32string& text, std::vector<uint64_t>& grams) {
+		for (size_t i = 0; i < text.size(); ++i) {
+			if (isSpace(text[i])) continue;
+			grams.push_back(unigram(text[i]));
+			if (i + 1 < text.size() && !isSpace(text[i + 1])) {
+				grams.push_back(bigram(text[i], text[i + 1]));
+			}
+		}
+	}
+
+	std::vector<std::u32string> splitTerms(const std::u32string& text) {
+		std::vector<std::u32string> terms;
+		std::u32string term;
+		for (const char32_t c : text) {
+			if (isSpace(c)) {
+				if (!term.empty()) terms.push_back(std::move(term));
+				term.clear();
+			} else {
+				term += c;
+			}
+		}
+		if (!term.empty()) terms.push_back(std::move(term));
+		return terms;
+	}
+
+	void intersect(std::vector<int>& into, const std::vector<int>& ids) {
+		std::vector<int> out;
+		std::set_intersection(into.begin(), into.end(), ids.begin(), ids.end(), std::back_inserter(out));
+		into.swap(out);
+	}
+}
+
+bool MenuSearchIndex::built() const {
+	std::shared_lock<std::shared_mutex> lock(mutex);
+	return isBuilt;
+}
+
+void MenuSearchIndex::rebuild(const std::vector<Dish>& dishes) {
+	std::unique_lock<std::shared_mutex> lock(mutex);
+	entries.clear();
+	postings.clear();
+	for (const auto& dish : dishes) {
+		insertLocked(dish);
+	}
+	isBuilt = true;
+}
+
+void MenuSearchIndex::upsert(const Dish& dish) {
+	std::unique_lock<std::shared_mutex> lock(mutex);
+	eraseLocked(dish.id);
+	insertLocked(dish);
+}
+
+void MenuSearchIndex::clear() {
+	std::unique_lock<std::shared_mutex> lock(mutex);
+	entries.clear();
+	postings.clear();
+	isBuilt = false;
+}
+
+void MenuSearchIndex::insertLocked(const Dish& dish) {
+	Entry entry{dish, fold(dish.name), fold(dish.description), fold(dish.category), {}};
+	addGrams(entry.name, entry.grams);
+	addGrams(entry.description, entry.grams);
+	addGrams(entry.category, entry.grams);
+	std::sort(entry.grams.begin(), entry.grams.end());
+	entry.grams.erase(std::unique(entry.grams.begin(), entry.grams.end()), entry.grams.end());
+	for (const uint64_t gram : entry.grams) {
+		auto& ids = postings[gram];
+		ids.insert(std::lower_bound(ids.begin(), ids.end(), dish.id), dish.id);
+	}
+	entries[dish.id] = std::move(entry);
+}
+
+void MenuSearchIndex::eraseLocked(int dishId) {
+	const auto it = entries.find(dishId);
+	if (it == entries.end()) {
+		return;
+	}
+	for (const uint64_t gram : it->second.grams) {
+		const auto posting = postings.find(gram);
+		if (posting == postings.end()) continue;
+		auto& ids = posting->second;
+		const auto pos = std::lower_bound(ids.begin(), ids.end(), dishId);
+		if (pos != ids.end() && *pos == dishId) {
+			ids.erase(pos);
+		}
+		if (ids.empty()) {
+			postings.erase(posting);
+		}
+	}
+	entries.erase(it);
+}
+
+std::optional<std::vector<Dish>> MenuSearchIndex::search(const std::string& query, const std::optional<std::string>& category) const {
+	const std::vector<std::u32string> terms = splitTerms(fold(query));
+	const std::optional<std::u32string> wantCategory = category ? std::optional<std::u32string>(fold(category.value())) : std::nullopt;
+	std::shared_lock<std::shared_mutex> lock(mutex);
+	if (!isBuilt) {
+		return std::nullopt;
+	}
+
+	std::vector<int> candidates;
+	bool all = true;
+	for (const auto& term : terms) {
+		std::vector<uint64_t> grams;
+		if (term.size() == 1) {
+			grams.push_back(unigram(term[0]));
+		} else {
+			for (size_t i = 0; i + 1 < term.size(); ++i) {
+				grams.push_back(bigram(term[i], term[i + 1]));
+			}
+		}
+		for (const uint64_t gram : grams) {
+			const auto posting = postings.find(gram);
+			if (posting == postings.end()) {
+				return std::vector<Dish>();
+			}
+			if (all) {
+				candidates = posting->second;
+				all = false;
+			} else {
+				intersect(candidates, posting->second);
+			}
+			if (candidates.empty()) {
+				return std::vector<Dish>();
+			}
+		}
+	}
+	if (all) {
+		for (const auto& kv : entries) {
+			candidates.push_back(kv.first);
+		}
+		std::sort(candidates.begin(), candidates.end());
+	}
+
+	std::vector<Dish> nameMatches;
+	std::vector<Dish> otherMatches;
+	for (const int id : candidates) {
+		const Entry& entry = entries.at(id);
+		if (!entry.dish.isAvailable) continue;
+		if (wantCategory && entry.category != wantCategory.value()) continue;
+		bool inName = true;
+		bool matches = true;
+		for (const auto& term : terms) {
+			const bool nameHit = entry.name.find(term) != std::u32string::npos;
+			inName = inName && nameHit;
+			if (!nameHit && entry.description.find(term) == std::u32string::npos && entry.category.find(term) == std::u32string::npos) {
+				matches = false;
+				break;
+			}
+		}
+		if (!matches) continue;
+		(inName ? nameMatches : otherMatches).push_back(entry.dish);
+	}
+	nameMatches.insert(nameMatches.end(), otherMatches.begin(), otherMatches.end());
+	return nameMatches;
+}
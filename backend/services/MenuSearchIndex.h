@@ -0,0 +1,47 @@
+#pragma once
+#include <cstdint>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "../models/Dish.h"
+
+// Inverted index over dish name, description and category for substring
+// search. Text is split into code points (ASCII and full-width Latin folded
+// to lower-case half-width) and indexed as unigrams and bigrams, so Chinese
+// names match on any substring without word segmentation. Candidates from
+// the postings are verified against the folded text, so results are exact.
+class MenuSearchIndex {
+public:
+	bool built() const;
+	// Replaces the whole index.
+	void rebuild(const std::vector<Dish>& dishes);
+	// Adds the dish or replaces the indexed copy with the same id.
+	void upsert(const Dish& dish);
+	// Drops everything; built() is false until the next rebuild.
+	void clear();
+	// Available dishes containing every whitespace-separated term of query,
+	// optionally only in category; name matches first, then by id. An empty
+	// query matches all. nullopt if the index has not been built.
+	std::optional<std::vector<Dish>> search(const std::string& query, const std::optional<std::string>& category) const;
+
+private:
+	struct Entry {
+		Dish dish;
+		std::u32string name;
+		std::u32string description;
+		std::u32string category;
+		std::vector<uint64_t> grams;
+	};
+
+	// Callers hold mutex exclusively.
+	void insertLocked(const Dish& dish);
+	void eraseLocked(int dishId);
+
+	mutable std::shared_mutex mutex;
+	bool isBuilt{false};
+	std::unordered_map<int, Entry> entries;
+	// Gram -> ascending dish ids.
+	std::unordered_map<uint64_t, std::vector<int>> postings;
+};
@@ -1,16 +1,148 @@
 #include "MenuService.h"
-#include "../database/Database.h"
+#include "../database/Storage.h"
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <cstdio>
+
+using json = nlohmann::json;
+
+namespace {
+	// FNV-1a, 64-bit: cheap and stable across processes, which is all an
+	// ETag needs.
+	std::string menuEtag(const std::string& body) {
+		uint64_t hash = 14695981039346656037ull;
+		for (const unsigned char c : body) {
+			hash ^= c;
+			hash *= 1099511628211ull;
+		}
+		char buf[24];
+		std::snprintf(buf, sizeof(buf), "\"%016llx\"", static_cast<unsigned long long>(hash));
+		return buf;
+	}
+
+	std::string serializeMenu(const std::vector<Dish>& dishes) {
+		json arr = json::array();
+		for (const auto& d : dishes) {
+			if (!d.isAvailable) continue;
+			arr.push_back({
+				{"id", d.id},
+				{"name", d.name},
+				{"description", d.description},
+				{"category", d.category},
+				{"price", d.price}
+			});
+		}
+		return arr.dump();
+	}
+
+	const Dish* findDish(const MenuSnapshot& menu, int dishId) {
+		const auto it = std::lower_bound(menu.dishes.begin(), menu.dishes.end(), dishId,
+			[](const Dish& dish, int id) { return dish.id < id; });
+		return it == menu.dishes.end() || it->id != dishId ? nullptr : &*it;
+	}
+}
 
 std::vector<Dish> MenuService::getMenu(std::string& errMsg) {
-	return Database::instance().getAllDishes(errMsg);
+	auto menu = getMenuSnapshot(errMsg);
+	return menu ? menu->dishes : std::vector<Dish>();
+}
+
+std::shared_ptr<const MenuSnapshot> MenuService::getMenuSnapshot(std::string& errMsg) {
+	if (auto current = snapshot.load()) {
+		return current;
+	}
+	std::lock_guard<std::mutex> rebuild(rebuildMutex);
+	// Another request may have built it while we waited.
+	if (auto current = snapshot.load()) {
+		return current;
+	}
+	return rebuildSnapshot(errMsg);
+}
+
+std::shared_ptr<const MenuSnapshot> MenuService::rebuildSnapshot(std::string& errMsg) {
+	auto dishes = Storage::instance().getAllDishes(errMsg);
+	if (!errMsg.empty()) {
+		snapshot.store(nullptr);
+		return nullptr;
+	}
+	auto next = std::make_shared<MenuSnapshot>();
+	std::string body = serializeMenu(dishes);
+	next->etag = menuEtag(body);
+	next->body = EncodedBody::encode(std::move(body));
+	next->dishes = std::move(dishes);
+	next->version = ++snapshotVersion;
+	std::shared_ptr<const MenuSnapshot> published = std::move(next);
+	snapshot.store(published);
+	return published;
+}
+
+void MenuService::reindexDish(const std::shared_ptr<const MenuSnapshot>& menu, int dishId) {
+	if (!searchIndex.built()) {
+		return;
+	}
+	if (!menu) {
+		searchIndex.clear();
+	} else if (const Dish* dish = findDish(*menu, dishId)) {
+		searchIndex.upsert(*dish);
+	}
 }
 
 std::optional<Dish> MenuService::getDish(int dishId, std::string& errMsg) {
-	return Database::instance().getDish(dishId, errMsg);
+	auto menu = getMenuSnapshot(errMsg);
+	if (!menu) {
+		return std::nullopt;
+	}
+	const Dish* dish = findDish(*menu, dishId);
+	if (!dish) {
+		return std::nullopt;
+	}
+	return *dish;
+}
+
+std::optional<std::vector<Dish>> MenuService::searchMenu(const std::string& query, const std::optional<std::string>& category, std::string& errMsg) {
+	if (auto found = searchIndex.search(query, category)) {
+		return found;
+	}
+	std::lock_guard<std::mutex> rebuild(rebuildMutex);
+	if (!searchIndex.built()) {
+		// Indexes the published snapshot, so search and /menu agree.
+		auto menu = snapshot.load();
+		if (!menu) {
+			menu = rebuildSnapshot(errMsg);
+		}
+		if (!menu) {
+			return std::nullopt;
+		}
+		searchIndex.rebuild(menu->dishes);
+	}
+	return searchIndex.search(query, category);
+}
+
+std::vector<Dish> MenuService::getMenuPage(int afterId, int limit, std::string& errMsg) {
+	return Storage::instance().getDishesPage(afterId, limit, errMsg);
 }
 
 std::optional<int> MenuService::createDish(const Dish& dish, std::string& errMsg) {
-	return Database::instance().createDish(dish, errMsg);
+	auto id = Storage::instance().createDish(dish, errMsg);
+	if (id) {
+		std::string rebuildErr;
+		std::lock_guard<std::mutex> rebuild(rebuildMutex);
+		reindexDish(rebuildSnapshot(rebuildErr), id.value());
+	}
+	return id;
+}
+
+std::optional<int> MenuService::importDishes(const std::vector<Dish>& dishes, std::string& errMsg) {
+	auto count = Storage::instance().upsertDishes(dishes, errMsg);
+	if (count) {
+		std::string rebuildErr;
+		std::lock_guard<std::mutex> rebuild(rebuildMutex);
+		rebuildSnapshot(rebuildErr);
+		// Imports can touch thousands of rows; reindexing from scratch on the
+		// next search is cheaper than one upsert per row.
+		searchIndex.clear();
+	}
+	return count;
 }
 
 bool MenuService::updateDish(int dishId,
@@ -20,7 +152,11 @@ bool MenuService::updateDish(int dishId,
 	const std::optional<double>& price,
 	const std::optional<bool>& isAvailable,
 	std::string& errMsg) {
-	return Database::instance().updateDish(dishId, name, description, category, price, isAvailable, errMsg);
+	if (!Storage::instance().updateDish(dishId, name, description, category, price, isAvailable, errMsg)) {
+		return false;
+	}
+	std::string rebuildErr;
+	std::lock_guard<std::mutex> rebuild(rebuildMutex);
+	reindexDish(rebuildSnapshot(rebuildErr), dishId);
+	return true;
 }
-
-
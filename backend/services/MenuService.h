@@ -1,14 +1,47 @@
 #pragma once
+#include <cstdint>
+#include <memory>
+#include <mutex>
 #include <vector>
 #include <string>
 #include <optional>
 #include "../models/Dish.h"
+#include "../database/Published.h"
+#include "MenuSearchIndex.h"
+#include "ResponseCompression.h"
+
+// The whole menu as of one write, immutable once published. Readers share
+// it through a Published, so reading it takes no lock unless a rebuild
+// happened since that thread last looked. A replaced snapshot lives on
+// until each thread that read it reads again or exits.
+struct MenuSnapshot {
+	// Increases with every rebuild in this process.
+	uint64_t version;
+	// Every dish, available or not, ascending by id.
+	std::vector<Dish> dishes;
+	// The public /menu body (available dishes only), serialized and compressed.
+	EncodedBody body;
+	// Quoted strong ETag of the JSON, so it stays valid across restarts.
+	// Compressed forms are distinct representations; see MenuController.
+	std::string etag;
+};
 
 class MenuService {
 public:
+	// Served from the snapshot, like getDish.
 	std::vector<Dish> getMenu(std::string& errMsg);
+	// Built on first use and rebuilt after every successful menu write made
+	// through this service; nullptr only if the menu cannot be read. Takes no
+	// lock while the snapshot is unchanged.
+	std::shared_ptr<const MenuSnapshot> getMenuSnapshot(std::string& errMsg);
 	std::optional<Dish> getDish(int dishId, std::string& errMsg);
+	// See MenuSearchIndex::search; the index is built on first use and kept
+	// current by the writes below. nullopt only if the menu cannot be read.
+	std::optional<std::vector<Dish>> searchMenu(const std::string& query, const std::optional<std::string>& category, std::string& errMsg);
+	std::vector<Dish> getMenuPage(int afterId, int limit, std::string& errMsg);
 	std::optional<int> createDish(const Dish& dish, std::string& errMsg);
+	// All rows or none; see Storage::upsertDishes.
+	std::optional<int> importDishes(const std::vector<Dish>& dishes, std::string& errMsg);
 	bool updateDish(int dishId,
 		const std::optional<std::string>& name,
 		const std::optional<std::string>& description,
@@ -16,6 +49,21 @@ public:
 		const std::optional<double>& price,
 		const std::optional<bool>& isAvailable,
 		std::string& errMsg);
-};
 
+private:
+	// Re-reads the menu and publishes the next snapshot; caller holds
+	// rebuildMutex. On failure the current one is dropped so the next reader
+	// retries instead of serving a menu that is known to be stale.
+	std::shared_ptr<const MenuSnapshot> rebuildSnapshot(std::string& errMsg);
+	// Copies one dish from the snapshot just published into the search index,
+	// if it has been built; without a snapshot the index is dropped and
+	// rebuilt by the next search. Caller holds rebuildMutex.
+	void reindexDish(const std::shared_ptr<const MenuSnapshot>& menu, int dishId);
 
+	// Serializes snapshot rebuilds and index updates, so a later one always
+	// reads later data. Also guards snapshotVersion.
+	std::mutex rebuildMutex;
+	Published<MenuSnapshot> snapshot;
+	uint64_t snapshotVersion{0};
+	MenuSearchIndex searchIndex;
+};
@@ -0,0 +1,281 @@
+#include "MenuTransfer.h"
+#include "JsonValues.h"
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+
+using json = nlohmann::json;
+
+namespace {
+	const char* const kColumns[] = {"id", "name", "description", "category", "price", "isAvailable"};
+
+	std::string lowercase(std::string s) {
+		std::transform(s.begin(), s.end(), s.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+		return s;
+	}
+
+	// Splits one CSV record (RFC 4180 quoting, "" inside quotes is a quote).
+	bool splitCsv(const std::string& record, std::vector<std::string>& fields) {
+		fields.assign(1, std::string());
+		bool quoted = false;
+		for (size_t i = 0; i < record.size(); ++i) {
+			const char c = record[i];
+			if (quoted) {
+				if (c != '"') {
+					fields.back() += c;
+				} else if (i + 1 < record.size() && record[i + 1] == '"') {
+					fields.back() += '"';
+					++i;
+				} else {
+					quoted = false;
+				}
+			} else if (c == '"') {
+				quoted = true;
+			} else if (c == ',') {
+				fields.emplace_back();
+			} else {
+				fields.back() += c;
+			}
+		}
+		return !quoted;
+	}
+
+	std::string quoteCsv(const std::string& value) {
+		if (value.find_first_of(",\"\r\n") == std::string::npos) {
+			return value;
+		}
+		std::string out = "\"";
+		for (const char c : value) {
+			out += c;
+			if (c == '"') out += '"';
+		}
+		return out + "\"";
+	}
+
+	bool parseCsvInt(const std::string& value, int& out) {
+		try {
+			size_t used = 0;
+			out = std::stoi(value, &used);
+			return used == value.size();
+		} catch (const std::exception&) {
+			return false;
+		}
+	}
+
+	bool parseCsvDouble(const std::string& value, double& out) {
+		try {
+			size_t used = 0;
+			out = std::stod(value, &used);
+			return used == value.size();
+		} catch (const std::exception&) {
+			return false;
+		}
+	}
+
+	bool parseCsvBool(const std::string& value, bool& out) {
+		const std::string v = lowercase(value);
+		if (v.empty() || v == "true" || v == "1") {
+			out = true;
+		} else if (v == "false" || v == "0") {
+			out = false;
+		} else {
+			return false;
+		}
+		return true;
+	}
+
+	std::string formatPrice(double price) {
+		char buf[32];
+		std::snprintf(buf, sizeof(buf), "%.15g", price);
+		return buf;
+	}
+}
+
+std::optional<MenuFormat> parseMenuFormat(const std::string& value) {
+	const std::string v = lowercase(value.substr(0, value.find(';')));
+	if (v == "csv" || v == "text/csv") {
+		return MenuFormat::Csv;
+	}
+	if (v == "ndjson" || v == "application/x-ndjson" || v == "application/ndjson" || v == "application/jsonl") {
+		return MenuFormat::Ndjson;
+	}
+	return std::nullopt;
+}
+
+const char* menuFormatContentType(MenuFormat format) {
+	return format == MenuFormat::Csv ? "text/csv; charset=utf-8" : "application/x-ndjson";
+}
+
+bool MenuImportParser::feed(const char* data, size_t size, std::string& errMsg) {
+	for (size_t i = 0; i < size; ++i) {
+		const char c = data[i];
+		if (c == '\n') {
+			++line;
+			if (!inQuotes) {
+				if (!parseRecord(errMsg)) {
+					return false;
+				}
+				recordLine = line;
+				continue;
+			}
+		} else if (c == '"' && format == MenuFormat::Csv) {
+			inQuotes = !inQuotes;
+		}
+		record += c;
+	}
+	return true;
+}
+
+bool MenuImportParser::finish(std::string& errMsg) {
+	if (inQuotes) {
+		errMsg = "line " + std::to_string(recordLine) + ": unterminated quoted field";
+		return false;
+	}
+	return parseRecord(errMsg);
+}
+
+bool MenuImportParser::parseRecord(std::string& errMsg) {
+	if (!record.empty() && record.back() == '\r') {
+		record.pop_back();
+	}
+	if (record.find_first_not_of(" \t") == std::string::npos) {
+		record.clear();
+		return true;
+	}
+	Dish dish{};
+	dish.isAvailable = true;
+	bool isHeader = false;
+	const bool ok = format == MenuFormat::Csv ? parseCsv(dish, isHeader, errMsg) : parseNdjson(dish, errMsg);
+	record.clear();
+	if (!ok) {
+		errMsg = "line " + std::to_string(recordLine) + ": " + errMsg;
+		return false;
+	}
+	if (isHeader) {
+		return true;
+	}
+	// !(price > 0) also rejects NaN, which parseCsvDouble accepts.
+	if (dish.id < 0 || dish.name.empty() || !(dish.price > 0) || !std::isfinite(dish.price)) {
+		errMsg = "line " + std::to_string(recordLine) + ": name and positive finite price required";
+		return false;
+	}
+	if (parsed.size() >= kMaxRows) {
+		errMsg = "more than " + std::to_string(kMaxRows) + " rows";
+		return false;
+	}
+	parsed.push_back(std::move(dish));
+	return true;
+}
+
+bool MenuImportParser::parseNdjson(Dish& dish, std::string& errMsg) {
+	json row;
+	try {
+		row = json::parse(record);
+	} catch (const std::exception& e) {
+		errMsg = std::string("invalid json: ") + e.what();
+		return false;
+	}
+	if (!row.is_object()) {
+		errMsg = "expected a JSON object";
+		return false;
+	}
+	const auto has = [&](const char* key) { return row.contains(key) && !row[key].is_null(); };
+	const auto invalid = [&](const char* key) {
+		errMsg = std::string("invalid ") + key;
+		return false;
+	};
+	if (has("id")) {
+		const auto id = jsonIntValue(row["id"]);
+		if (!id) return invalid("id");
+		dish.id = *id;
+	}
+	if (has("name")) {
+		if (!row["name"].is_string()) return invalid("name");
+		dish.name = row["name"].get<std::string>();
+	}
+	if (has("description")) {
+		if (!row["description"].is_string()) return invalid("description");
+		dish.description = row["description"].get<std::string>();
+	}
+	if (has("category")) {
+		if (!row["category"].is_string()) return invalid("category");
+		dish.category = row["category"].get<std::string>();
+	}
+	if (has("price")) {
+		if (!row["price"].is_number()) return invalid("price");
+		dish.price = row["price"].get<double>();
+	}
+	if (has("isAvailable")) {
+		if (!row["isAvailable"].is_boolean()) return invalid("isAvailable");
+		dish.isAvailable = row["isAvailable"].get<bool>();
+	}
+	return true;
+}
+
+bool MenuImportParser::parseCsv(Dish& dish, bool& isHeader, std::string& errMsg) {
+	std::vector<std::string> fields;
+	if (!splitCsv(record, fields)) {
+		errMsg = "unterminated quoted field";
+		return false;
+	}
+	if (columns.empty()) {
+		isHeader = true;
+		for (const auto& name : fields) {
+			const auto known = std::find_if(std::begin(kColumns), std::end(kColumns), [&](const char* c) { return lowercase(c) == lowercase(name); });
+			columns.push_back(known == std::end(kColumns) ? std::string() : std::string(*known));
+		}
+		if (std::find(columns.begin(), columns.end(), "name") == columns.end() || std::find(columns.begin(), columns.end(), "price") == columns.end()) {
+			errMsg = "header must name at least the name and price columns";
+			return false;
+		}
+		return true;
+	}
+	if (fields.size() != columns.size()) {
+		errMsg = "expected " + std::to_string(columns.size()) + " fields, got " + std::to_string(fields.size());
+		return false;
+	}
+	for (size_t i = 0; i < fields.size(); ++i) {
+		const std::string& column = columns[i];
+		const std::string& value = fields[i];
+		bool ok = true;
+		if (column == "id") {
+			ok = value.empty() || parseCsvInt(value, dish.id);
+		} else if (column == "name") {
+			dish.name = value;
+		} else if (column == "description") {
+			dish.description = value;
+		} else if (column == "category") {
+			dish.category = value;
+		} else if (column == "price") {
+			ok = parseCsvDouble(value, dish.price);
+		} else if (column == "isAvailable") {
+			ok = parseCsvBool(value, dish.isAvailable);
+		}
+		if (!ok) {
+			errMsg = "invalid " + column;
+			return false;
+		}
+	}
+	return true;
+}
+
+std::string menuExportHeader(MenuFormat format) {
+	return format == MenuFormat::Csv ? "id,name,description,category,price,isAvailable\r\n" : "";
+}
+
+std::string formatMenuRow(const Dish& dish, MenuFormat format) {
+	if (format == MenuFormat::Ndjson) {
+		return json{
+			{"id", dish.id},
+			{"name", dish.name},
+			{"description", dish.description},
+			{"category", dish.category},
+			{"price", dish.price},
+			{"isAvailable", dish.isAvailable}
+		}.dump() + "\n";
+	}
+	return std::to_string(dish.id) + "," + quoteCsv(dish.name) + "," + quoteCsv(dish.description) + "," +
+		quoteCsv(dish.category) + "," + formatPrice(dish.price) + "," + (dish.isAvailable ? "true" : "false") + "\r\n";
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <vector>
+#include "../models/Dish.h"
+
+// Wire formats for bulk menu import/export. Both carry the fields of the
+// admin dish JSON: id, name, description, category, price, isAvailable.
+// NDJSON is one object per line; CSV has a header row naming the columns.
+enum class MenuFormat {
+	Ndjson,
+	Csv,
+};
+
+// "ndjson"/"csv", or a Content-Type such as "text/csv; charset=utf-8".
+std::optional<MenuFormat> parseMenuFormat(const std::string& value);
+const char* menuFormatContentType(MenuFormat format);
+
+// Incremental parser for an import body, fed as it arrives so the upload is
+// never held in memory as a whole. Rows without an id (or id 0) are new
+// dishes; rows with an id replace that dish. Errors name the line.
+class MenuImportParser {
+public:
+	static constexpr size_t kMaxRows = 20000;
+
+	explicit MenuImportParser(MenuFormat format) : format(format) {}
+
+	bool feed(const char* data, size_t size, std::string& errMsg);
+	// Parses a last line that has no trailing newline.
+	bool finish(std::string& errMsg);
+	std::vector<Dish>& rows() { return parsed; }
+
+private:
+	bool parseRecord(std::string& errMsg);
+	bool parseNdjson(Dish& dish, std::string& errMsg);
+	bool parseCsv(Dish& dish, bool& isHeader, std::string& errMsg);
+
+	MenuFormat format;
+	std::string record;
+	// CSV only: a newline inside quotes does not end the record.
+	bool inQuotes{false};
+	size_t line{1};
+	size_t recordLine{1};
+	std::vector<std::string> columns;
+	std::vector<Dish> parsed;
+};
+
+// The CSV header line, or "" for NDJSON.
+std::string menuExportHeader(MenuFormat format);
+// One exported dish, newline-terminated.
+std::string formatMenuRow(const Dish& dish, MenuFormat format);
@@ -0,0 +1,125 @@
+#include "OrderEventHub.h"
+
+std::vector<OrderStatusEvent> OrderSubscription::wait(std::chrono::milliseconds timeout) {
+	std::unique_lock<std::mutex> lock(mutex);
+	ready.wait_for(lock, timeout, [this]() { return isClosed || !pending.empty(); });
+	std::vector<OrderStatusEvent> events;
+	if (isClosed) {
+		return events;
+	}
+	events.assign(std::make_move_iterator(pending.begin()), std::make_move_iterator(pending.end()));
+	pending.clear();
+	return events;
+}
+
+bool OrderSubscription::closed() const {
+	std::lock_guard<std::mutex> lock(mutex);
+	return isClosed;
+}
+
+OrderEventHub::OrderEventHub(size_t maxSubscribers, std::chrono::seconds heartbeat)
+	: maxSubscribers(maxSubscribers),
+	  heartbeat(heartbeat),
+	  nextId(static_cast<uint64_t>(nowEpochMillis()) * 1000) {}
+
+std::shared_ptr<OrderSubscription> OrderEventHub::subscribe(const std::optional<int>& orderId, const std::optional<int>& userId,
+	const std::optional<uint64_t>& lastEventId, bool& resumed) {
+	auto subscription = std::make_shared<OrderSubscription>();
+	subscription->orderId = orderId;
+	subscription->userId = userId;
+	resumed = false;
+
+	std::lock_guard<std::mutex> lock(mutex);
+	if (subscribers >= maxSubscribers) {
+		return nullptr;
+	}
+	// Replay under the same lock as registration, so no event falls between.
+	const uint64_t oldest = recent.empty() ? nextId : recent.front().id;
+	if (lastEventId && lastEventId.value() + 1 >= oldest && lastEventId.value() < nextId) {
+		resumed = true;
+		for (const auto& event : recent) {
+			if (event.id > lastEventId.value() && matches(*subscription, event.order)) {
+				subscription->pending.push_back(event);
+			}
+		}
+	}
+	if (orderId) {
+		byOrder[orderId.value()].insert(subscription.get());
+	} else if (userId) {
+		byUser[userId.value()].insert(subscription.get());
+	}
+	++subscribers;
+	return subscription;
+}
+
+void OrderEventHub::unsubscribe(const std::shared_ptr<OrderSubscription>& subscription) {
+	std::lock_guard<std::mutex> lock(mutex);
+	const auto drop = [&](std::unordered_map<int, SubscriberSet>& index, int key) {
+		const auto it = index.find(key);
+		if (it == index.end() || it->second.erase(subscription.get()) == 0) {
+			return false;
+		}
+		if (it->second.empty()) {
+			index.erase(it);
+		}
+		return true;
+	};
+	const bool removed = subscription->orderId ? drop(byOrder, subscription->orderId.value())
+		: subscription->userId ? drop(byUser, subscription->userId.value()) : false;
+	if (removed) {
+		--subscribers;
+	}
+}
+
+void OrderEventHub::publish(const Order& order) {
+	std::lock_guard<std::mutex> lock(mutex);
+	OrderStatusEvent event{nextId++, order};
+	const auto notify = [&](std::unordered_map<int, SubscriberSet>& index, int key) {
+		const auto it = index.find(key);
+		if (it == index.end()) return;
+		for (OrderSubscription* subscription : it->second) {
+			deliver(*subscription, event);
+		}
+	};
+	notify(byOrder, order.id);
+	if (order.userId) {
+		notify(byUser, order.userId.value());
+	}
+	recent.push_back(std::move(event));
+	if (recent.size() > kReplayCapacity) {
+		recent.pop_front();
+	}
+}
+
+uint64_t OrderEventHub::lastEventId() const {
+	std::lock_guard<std::mutex> lock(mutex);
+	return nextId - 1;
+}
+
+size_t OrderEventHub::subscriberCount() const {
+	std::lock_guard<std::mutex> lock(mutex);
+	return subscribers;
+}
+
+bool OrderEventHub::matches(const OrderSubscription& subscription, const Order& order) {
+	if (subscription.orderId) {
+		return subscription.orderId.value() == order.id;
+	}
+	return subscription.userId && order.userId == subscription.userId;
+}
+
+void OrderEventHub::deliver(OrderSubscription& subscription, const OrderStatusEvent& event) {
+	{
+		std::lock_guard<std::mutex> lock(subscription.mutex);
+		if (subscription.isClosed) {
+			return;
+		}
+		if (subscription.pending.size() >= kMaxPending) {
+			subscription.isClosed = true;
+			subscription.pending.clear();
+		} else {
+			subscription.pending.push_back(event);
+		}
+	}
+	subscription.ready.notify_one();
+}
@@ -0,0 +1,82 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "../models/Order.h"
+
+// An order as it was right after a committed change. Ids increase for the
+// life of the process and start from the boot time, so an id handed out by
+// an earlier process is always older than the replay buffer.
+struct OrderStatusEvent {
+	uint64_t id;
+	Order order;
+};
+
+// One open event stream, following one order or all orders of one user.
+// The hub queues matching events here; the stream's thread takes them.
+class OrderSubscription {
+public:
+	// Waits up to timeout; empty on timeout or once closed.
+	std::vector<OrderStatusEvent> wait(std::chrono::milliseconds timeout);
+	bool closed() const;
+
+private:
+	friend class OrderEventHub;
+
+	std::optional<int> orderId;
+	std::optional<int> userId;
+	mutable std::mutex mutex;
+	std::condition_variable ready;
+	std::deque<OrderStatusEvent> pending;
+	bool isClosed{false};
+};
+
+// Fans committed order changes out to event-stream subscribers. Publishing
+// touches only the subscribers of that order and its user, so idle streams
+// cost a queue and a sleeping thread each. The most recent events are kept
+// so a reconnecting client can resume from its Last-Event-ID.
+class OrderEventHub {
+public:
+	static constexpr size_t kReplayCapacity = 4096;
+	// A subscriber this far behind is closed; it resumes on reconnect.
+	static constexpr size_t kMaxPending = 256;
+
+	OrderEventHub(size_t maxSubscribers, std::chrono::seconds heartbeat);
+
+	// Exactly one of orderId and userId is set. With lastEventId, the missed
+	// events still buffered are queued first and resumed is set; otherwise
+	// (or if they are gone) the caller should send the current state.
+	// nullptr once maxSubscribers streams are open.
+	std::shared_ptr<OrderSubscription> subscribe(const std::optional<int>& orderId, const std::optional<int>& userId,
+		const std::optional<uint64_t>& lastEventId, bool& resumed);
+	void unsubscribe(const std::shared_ptr<OrderSubscription>& subscription);
+	// Call after the change is committed, in commit order.
+	void publish(const Order& order);
+
+	// Id of the newest event, for tagging state sent in place of a replay.
+	uint64_t lastEventId() const;
+	size_t subscriberCount() const;
+	std::chrono::seconds heartbeatInterval() const { return heartbeat; }
+
+private:
+	using SubscriberSet = std::unordered_set<OrderSubscription*>;
+
+	static bool matches(const OrderSubscription& subscription, const Order& order);
+	static void deliver(OrderSubscription& subscription, const OrderStatusEvent& event);
+
+	const size_t maxSubscribers;
+	const std::chrono::seconds heartbeat;
+	mutable std::mutex mutex;
+	uint64_t nextId;
+	std::deque<OrderStatusEvent> recent;
+	std::unordered_map<int, SubscriberSet> byOrder;
+	std::unordered_map<int, SubscriberSet> byUser;
+	size_t subscribers{0};
+};
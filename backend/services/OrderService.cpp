@@ -1,28 +1,127 @@
 #include "OrderService.h"
-#include "../database/Database.h"
+#include "../database/Storage.h"
+
+namespace {
+	// Pages are fetched with one extra row to learn whether another page follows.
+	OrderPage toPage(std::vector<Order> orders, int limit) {
+		OrderPage page;
+		if (static_cast<int>(orders.size()) > limit) {
+			orders.resize(limit);
+			page.nextBeforeId = orders.back().id;
+		}
+		page.orders = std::move(orders);
+		return page;
+	}
+}
+
+bool OrderService::loadActiveOrders(std::string& errMsg) {
+	auto orders = Storage::instance().getActiveOrders(errMsg);
+	if (!errMsg.empty()) {
+		return false;
+	}
+	activeOrders.rebuild(orders);
+	return true;
+}
 
 std::optional<int> OrderService::createOrder(const std::vector<OrderItem>& items, const std::optional<int>& userId, std::string& errMsg) {
-	return Database::instance().createOrder(items, userId, errMsg);
+	auto id = Storage::instance().createOrder(items, userId, errMsg);
+	if (id.has_value()) {
+		// The insert itself stays outside the lock so group commit can batch.
+		std::lock_guard<std::mutex> lock(updateMutex);
+		std::string err;
+		auto order = Storage::instance().getOrder(id.value(), err);
+		if (order.has_value()) {
+			activeOrders.insertIfAbsent(order.value());
+			events.publish(order.value());
+		}
+	}
+	return id;
 }
 
 std::optional<Order> OrderService::getOrder(int id, std::string& errMsg) {
-	return Database::instance().getOrder(id, errMsg);
+	auto active = activeOrders.get(id);
+	if (active.has_value()) {
+		return active;
+	}
+	return Storage::instance().getOrder(id, errMsg);
 }
 
-std::vector<Order> OrderService::getAllOrders(std::string& errMsg) {
-	return Database::instance().getAllOrders(errMsg);
+std::vector<Order> OrderService::getAllOrders(std::string& errMsg, bool includeArchived) {
+	return Storage::instance().getAllOrders(errMsg, includeArchived);
 }
 
-std::vector<Order> OrderService::getOrdersByUser(int userId, std::string& errMsg) {
-	return Database::instance().getOrdersByUser(userId, errMsg);
+std::vector<Order> OrderService::getOrdersByUser(int userId, std::string& errMsg, bool includeArchived) {
+	return Storage::instance().getOrdersByUser(userId, errMsg, includeArchived);
+}
+
+OrderPage OrderService::getAllOrdersPage(const std::optional<int>& beforeId, int limit, std::string& errMsg, bool includeArchived) {
+	return toPage(Storage::instance().getAllOrdersPage(beforeId, limit + 1, errMsg, includeArchived), limit);
+}
+
+OrderPage OrderService::getOrdersByUserPage(int userId, const std::optional<int>& beforeId, int limit, std::string& errMsg, bool includeArchived) {
+	return toPage(Storage::instance().getOrdersByUserPage(userId, beforeId, limit + 1, errMsg, includeArchived), limit);
 }
 
 bool OrderService::updateOrderStatus(int id, const std::string& status, std::string& errMsg) {
-	return Database::instance().updateOrderStatus(id, status, errMsg);
+	std::lock_guard<std::mutex> lock(updateMutex);
+	if (!Storage::instance().updateOrderStatus(id, status, errMsg)) {
+		return false;
+	}
+	refreshActiveOrder(id);
+	return true;
+}
+
+std::optional<std::vector<std::optional<Order>>> OrderService::updateOrderStatuses(const std::vector<OrderStatusUpdate>& updates, std::string& errMsg) {
+	std::lock_guard<std::mutex> lock(updateMutex);
+	auto results = Storage::instance().updateOrderStatuses(updates, errMsg);
+	if (!results.has_value()) {
+		// Some changes may have landed (event log); re-read rather than guess.
+		for (const auto& update : updates) {
+			refreshActiveOrder(update.orderId);
+		}
+		return results;
+	}
+	for (const auto& order : results.value()) {
+		if (order.has_value() && !order->archived) {
+			activeOrders.apply(order.value());
+			events.publish(order.value());
+		}
+	}
+	return results;
 }
 
 bool OrderService::markPickupNotified(int id, std::string& errMsg) {
-	return Database::instance().markOrderPickupNotified(id, errMsg);
+	std::lock_guard<std::mutex> lock(updateMutex);
+	if (!Storage::instance().markOrderPickupNotified(id, errMsg)) {
+		return false;
+	}
+	refreshActiveOrder(id);
+	return true;
+}
+
+SalesReport OrderService::getSalesReport(EpochDay fromDay, EpochDay toDay, std::string& errMsg) {
+	return Storage::instance().getSalesReport(fromDay, toDay, errMsg);
+}
+
+std::vector<Order> OrderService::getActiveOrders(const std::optional<std::string>& status) {
+	return activeOrders.list(status);
+}
+
+std::vector<Order> OrderService::getActiveOrdersByUser(int userId) {
+	return activeOrders.listByUser(userId);
+}
+
+void OrderService::refreshActiveOrder(int id) {
+	std::string err;
+	auto order = Storage::instance().getOrder(id, err);
+	if (order.has_value() && !order->archived) {
+		activeOrders.apply(order.value());
+		events.publish(order.value());
+	} else {
+		// Archived (so unchanged) or unknown state: drop it so reads fall
+		// back to the database.
+		activeOrders.remove(id);
+	}
 }
 
 
@@ -1,17 +1,56 @@
 #pragma once
+#include <mutex>
 #include <optional>
 #include <string>
 #include <vector>
 #include "../models/Order.h"
+#include "../models/SalesStats.h"
+#include "ActiveOrderStore.h"
+#include "OrderEventHub.h"
+
+struct OrderPage {
+	std::vector<Order> orders;
+	// Pass as before_id to fetch the next page; empty on the last page.
+	std::optional<int> nextBeforeId;
+};
 
 class OrderService {
 public:
+	static constexpr int kDefaultPageSize = 50;
+	static constexpr int kMaxPageSize = 200;
+
+	// Every committed order change is published to events.
+	explicit OrderService(OrderEventHub& events) : events(events) {}
+
+	// Loads in-flight orders from the database; call once at startup.
+	bool loadActiveOrders(std::string& errMsg);
+
 	std::optional<int> createOrder(const std::vector<OrderItem>& items, const std::optional<int>& userId, std::string& errMsg);
 	std::optional<Order> getOrder(int id, std::string& errMsg);
-	std::vector<Order> getAllOrders(std::string& errMsg);
-	std::vector<Order> getOrdersByUser(int userId, std::string& errMsg);
+	std::vector<Order> getAllOrders(std::string& errMsg, bool includeArchived = false);
+	std::vector<Order> getOrdersByUser(int userId, std::string& errMsg, bool includeArchived = false);
+	OrderPage getAllOrdersPage(const std::optional<int>& beforeId, int limit, std::string& errMsg, bool includeArchived = false);
+	OrderPage getOrdersByUserPage(int userId, const std::optional<int>& beforeId, int limit, std::string& errMsg, bool includeArchived = false);
 	bool updateOrderStatus(int id, const std::string& status, std::string& errMsg);
+	// See Storage::updateOrderStatuses; results are in request order.
+	std::optional<std::vector<std::optional<Order>>> updateOrderStatuses(const std::vector<OrderStatusUpdate>& updates, std::string& errMsg);
 	bool markPickupNotified(int id, std::string& errMsg);
+	// Inclusive UTC day range; days without orders are omitted.
+	SalesReport getSalesReport(EpochDay fromDay, EpochDay toDay, std::string& errMsg);
+
+	// Served from memory only.
+	std::vector<Order> getActiveOrders(const std::optional<std::string>& status);
+	std::vector<Order> getActiveOrdersByUser(int userId);
+
+private:
+	// Re-reads an order after a write, mirrors it into the active store and
+	// publishes it. Caller holds updateMutex.
+	void refreshActiveOrder(int id);
+
+	ActiveOrderStore activeOrders;
+	OrderEventHub& events;
+	// Keeps writes, their store refresh and their events in the same order.
+	std::mutex updateMutex;
 };
 
 
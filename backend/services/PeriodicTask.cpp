@@ -0,0 +1,57 @@
+#include "PeriodicTask.h"
+#include <cstdio>
+#include <exception>
+
+PeriodicTask::PeriodicTask(std::string name, std::chrono::milliseconds interval, std::function<void()> job)
+	: name(std::move(name)), interval(interval), job(std::move(job)) {}
+
+PeriodicTask::~PeriodicTask() {
+	stop();
+}
+
+void PeriodicTask::start() {
+	std::lock_guard<std::mutex> lock(mutex);
+	if (worker.joinable()) return;
+	stopping = false;
+	worker = std::thread([this]() { run(); });
+}
+
+void PeriodicTask::stop() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	wake.notify_all();
+	if (worker.joinable()) {
+		worker.join();
+	}
+}
+
+void PeriodicTask::trigger() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		triggered = true;
+	}
+	wake.notify_all();
+}
+
+void PeriodicTask::run() {
+	while (true) {
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			const auto ready = [&]() { return stopping || triggered; };
+			if (interval.count() > 0) {
+				wake.wait_for(lock, interval, ready);
+			} else {
+				wake.wait(lock, ready);
+			}
+			if (stopping) return;
+			triggered = false;
+		}
+		try {
+			job();
+		} catch (const std::exception& e) {
+			printf("Periodic task %s failed: %s\n", name.c_str(), e.what());
+		}
+	}
+}
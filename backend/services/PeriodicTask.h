@@ -0,0 +1,35 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// Runs a job on its own thread every `interval` until stopped or destroyed.
+// The first run happens one interval after start(). A zero interval runs the
+// job only when triggered.
+class PeriodicTask {
+public:
+	PeriodicTask(std::string name, std::chrono::milliseconds interval, std::function<void()> job);
+	~PeriodicTask();
+	PeriodicTask(const PeriodicTask&) = delete;
+	PeriodicTask& operator=(const PeriodicTask&) = delete;
+
+	void start();
+	void stop();
+	// Wakes the thread to run the job now instead of at the next tick.
+	void trigger();
+
+private:
+	void run();
+
+	const std::string name;
+	const std::chrono::milliseconds interval;
+	std::function<void()> job;
+	std::mutex mutex;
+	std::condition_variable wake;
+	bool stopping{false};
+	bool triggered{false};
+	std::thread worker;
+};
@@ -0,0 +1,190 @@
+#include "ResponseCompression.h"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cstdlib>
+#ifdef RESTAURANT_WITH_ZLIB
+#include <zlib.h>
+#endif
+#ifdef RESTAURANT_WITH_BROTLI
+#include <brotli/encode.h>
+#endif
+
+namespace {
+	std::atomic<size_t> minBytes{1024};
+
+	std::string trim(const std::string& s) {
+		const size_t first = s.find_first_not_of(" \t");
+		if (first == std::string::npos) return "";
+		return s.substr(first, s.find_last_not_of(" \t") - first + 1);
+	}
+
+	std::string lowercase(std::string s) {
+		std::transform(s.begin(), s.end(), s.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+		return s;
+	}
+
+	// Client weight for one coding: its own q, else the q of "*", else 0.
+	// A coding listed without q has weight 1.
+	double acceptWeight(const std::string& acceptEncoding, const std::string& coding) {
+		double weight = -1;
+		double wildcard = -1;
+		size_t pos = 0;
+		while (pos <= acceptEncoding.size()) {
+			size_t end = acceptEncoding.find(',', pos);
+			if (end == std::string::npos) end = acceptEncoding.size();
+			const std::string item = acceptEncoding.substr(pos, end - pos);
+			pos = end + 1;
+			const size_t semi = item.find(';');
+			const std::string name = lowercase(trim(item.substr(0, semi)));
+			double q = 1;
+			if (semi != std::string::npos) {
+				const std::string param = trim(item.substr(semi + 1));
+				if (param.size() > 2 && (param[0] == 'q' || param[0] == 'Q') && param[1] == '=') {
+					q = std::strtod(param.c_str() + 2, nullptr);
+				}
+			}
+			if (name == coding) {
+				weight = q;
+			} else if (name == "*") {
+				wildcard = q;
+			}
+		}
+		if (weight >= 0) return weight;
+		return wildcard >= 0 ? wildcard : 0;
+	}
+
+#ifdef RESTAURANT_WITH_ZLIB
+	std::optional<std::string> gzipCompress(const std::string& body, int level) {
+		z_stream stream{};
+		// 15 window bits plus 16 selects the gzip wrapper.
+		if (deflateInit2(&stream, level, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+			return std::nullopt;
+		}
+		std::string out(deflateBound(&stream, static_cast<uLong>(body.size())), '\0');
+		stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(body.data()));
+		stream.avail_in = static_cast<uInt>(body.size());
+		stream.next_out = reinterpret_cast<Bytef*>(&out[0]);
+		stream.avail_out = static_cast<uInt>(out.size());
+		const int rc = deflate(&stream, Z_FINISH);
+		out.resize(stream.total_out);
+		deflateEnd(&stream);
+		if (rc != Z_STREAM_END) {
+			return std::nullopt;
+		}
+		return out;
+	}
+#endif
+
+#ifdef RESTAURANT_WITH_BROTLI
+	std::optional<std::string> brotliCompress(const std::string& body, int quality) {
+		size_t size = BrotliEncoderMaxCompressedSize(body.size());
+		if (size == 0) {
+			return std::nullopt;
+		}
+		std::string out(size, '\0');
+		if (!BrotliEncoderCompress(quality, BROTLI_DEFAULT_WINDOW, BROTLI_MODE_TEXT, body.size(),
+				reinterpret_cast<const uint8_t*>(body.data()), &size, reinterpret_cast<uint8_t*>(&out[0]))) {
+			return std::nullopt;
+		}
+		out.resize(size);
+		return out;
+	}
+#endif
+}
+
+void setCompressionMinBytes(size_t bytes) {
+	minBytes = bytes;
+}
+
+size_t compressionMinBytes() {
+	return minBytes;
+}
+
+const char* contentEncodingName(ContentEncoding encoding) {
+	switch (encoding) {
+	case ContentEncoding::Gzip: return "gzip";
+	case ContentEncoding::Brotli: return "br";
+	default: return "";
+	}
+}
+
+bool contentEncodingSupported(ContentEncoding encoding) {
+	switch (encoding) {
+#ifdef RESTAURANT_WITH_ZLIB
+	case ContentEncoding::Gzip: return true;
+#endif
+#ifdef RESTAURANT_WITH_BROTLI
+	case ContentEncoding::Brotli: return true;
+#endif
+	case ContentEncoding::Identity: return true;
+	default: return false;
+	}
+}
+
+ContentEncoding negotiateEncoding(const std::string& acceptEncoding) {
+	if (acceptEncoding.empty()) {
+		return ContentEncoding::Identity;
+	}
+	ContentEncoding best = ContentEncoding::Identity;
+	double bestWeight = 0;
+	for (const ContentEncoding candidate : {ContentEncoding::Brotli, ContentEncoding::Gzip}) {
+		if (!contentEncodingSupported(candidate)) continue;
+		const double weight = acceptWeight(acceptEncoding, contentEncodingName(candidate));
+		if (weight > bestWeight) {
+			best = candidate;
+			bestWeight = weight;
+		}
+	}
+	return best;
+}
+
+std::optional<std::string> compressBody(const std::string& body, ContentEncoding encoding, CompressionEffort effort) {
+#ifdef RESTAURANT_WITH_ZLIB
+	if (encoding == ContentEncoding::Gzip) {
+		return gzipCompress(body, effort == CompressionEffort::Best ? 9 : 6);
+	}
+#endif
+#ifdef RESTAURANT_WITH_BROTLI
+	if (encoding == ContentEncoding::Brotli) {
+		return brotliCompress(body, effort == CompressionEffort::Best ? 11 : 5);
+	}
+#endif
+	(void)body;
+	(void)encoding;
+	(void)effort;
+	return std::nullopt;
+}
+
+EncodedBody EncodedBody::encode(std::string body) {
+	EncodedBody encoded;
+	encoded.identity = std::move(body);
+	if (encoded.identity.size() < compressionMinBytes()) {
+		return encoded;
+	}
+	const auto smaller = [&](ContentEncoding encoding) {
+		auto compressed = compressBody(encoded.identity, encoding, CompressionEffort::Best);
+		return compressed && compressed->size() < encoded.identity.size() ? std::move(*compressed) : std::string();
+	};
+	encoded.gzip = smaller(ContentEncoding::Gzip);
+	encoded.brotli = smaller(ContentEncoding::Brotli);
+	return encoded;
+}
+
+const std::string& EncodedBody::select(const std::string& acceptEncoding, ContentEncoding& encoding) const {
+	encoding = ContentEncoding::Identity;
+	if (acceptEncoding.empty() || (gzip.empty() && brotli.empty())) {
+		return identity;
+	}
+	const double br = brotli.empty() ? 0 : acceptWeight(acceptEncoding, "br");
+	const double gz = gzip.empty() ? 0 : acceptWeight(acceptEncoding, "gzip");
+	if (br > 0 && br >= gz) {
+		encoding = ContentEncoding::Brotli;
+		return brotli;
+	}
+	if (gz > 0) {
+		encoding = ContentEncoding::Gzip;
+		return gzip;
+	}
+	return identity;
+}
@@ -0,0 +1,47 @@
+#pragma once
+#include <cstddef>
+#include <optional>
+#include <string>
+
+// HTTP content codings this build can produce: gzip needs zlib
+// (RESTAURANT_WITH_ZLIB), br needs brotli (RESTAURANT_WITH_BROTLI). Without
+// either library every response goes out uncompressed.
+enum class ContentEncoding {
+	Identity,
+	Gzip,
+	Brotli,
+};
+
+// Best trades ratio for CPU and is meant for bodies compressed once and
+// served many times; Fast is for bodies compressed per request.
+enum class CompressionEffort {
+	Fast,
+	Best,
+};
+
+// Bodies smaller than this are never compressed. Call once at startup.
+void setCompressionMinBytes(size_t minBytes);
+size_t compressionMinBytes();
+
+// Content-Encoding header value; "" for Identity.
+const char* contentEncodingName(ContentEncoding encoding);
+bool contentEncodingSupported(ContentEncoding encoding);
+// The supported coding the client ranks highest (br before gzip on ties);
+// Identity if it accepts neither.
+ContentEncoding negotiateEncoding(const std::string& acceptEncoding);
+// nullopt if the coding is unsupported or compression fails.
+std::optional<std::string> compressBody(const std::string& body, ContentEncoding encoding, CompressionEffort effort);
+
+// A body with every supported compressed form computed up front, for
+// payloads that are cached and served many times.
+struct EncodedBody {
+	std::string identity;
+	// Empty when the body is below the threshold, the coding is unsupported
+	// or compressing would not make it smaller.
+	std::string gzip;
+	std::string brotli;
+
+	static EncodedBody encode(std::string body);
+	// The smallest form the client accepts; sets encoding accordingly.
+	const std::string& select(const std::string& acceptEncoding, ContentEncoding& encoding) const;
+};
@@ -0,0 +1,53 @@
+#include "SessionSweeper.h"
+#include <cstdio>
+#include <string>
+#include <thread>
+#include "../database/Storage.h"
+
+namespace {
+	// Gap between batches so writers queued on the connection get a turn.
+	constexpr auto kPauseBetweenBatches = std::chrono::milliseconds(2);
+}
+
+SessionSweeper::SessionSweeper(std::chrono::milliseconds interval, int batchSize)
+	: batchSize(batchSize > 0 ? batchSize : 1), task("session-sweeper", interval, [this]() { sweep(); }) {}
+
+void SessionSweeper::start() {
+	task.start();
+	task.trigger();
+}
+
+void SessionSweeper::stop() {
+	task.stop();
+}
+
+void SessionSweeper::sweep() {
+	uint64_t removedThisRun = 0;
+	while (true) {
+		std::string err;
+		const auto started = std::chrono::steady_clock::now();
+		auto removed = Storage::instance().deleteExpiredSessions(batchSize, err);
+		const auto micros = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+			std::chrono::steady_clock::now() - started).count());
+		if (!removed.has_value()) {
+			printf("Session sweep failed: %s\n", err.c_str());
+			break;
+		}
+		lastBatchMicros = micros;
+		uint64_t seenMax = maxBatchMicros.load();
+		while (micros > seenMax && !maxBatchMicros.compare_exchange_weak(seenMax, micros)) {
+		}
+		removedThisRun += static_cast<uint64_t>(removed.value());
+		rowsRemoved += static_cast<uint64_t>(removed.value());
+		if (removed.value() < batchSize) {
+			break;
+		}
+		std::this_thread::sleep_for(kPauseBetweenBatches);
+	}
+	lastRunRowsRemoved = removedThisRun;
+	++runs;
+}
+
+SessionSweepStats SessionSweeper::stats() const {
+	return SessionSweepStats{runs.load(), rowsRemoved.load(), lastRunRowsRemoved.load(), lastBatchMicros.load(), maxBatchMicros.load()};
+}
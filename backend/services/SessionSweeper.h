@@ -0,0 +1,37 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include "PeriodicTask.h"
+
+struct SessionSweepStats {
+	uint64_t runs;
+	uint64_t rowsRemoved;
+	uint64_t lastRunRowsRemoved;
+	uint64_t lastBatchMicros;
+	uint64_t maxBatchMicros;
+};
+
+// Deletes expired sessions on a background thread. Each batch is its own
+// short write transaction of at most batchSize rows, and the writer is
+// released between batches so logins and orders are not held up.
+class SessionSweeper {
+public:
+	SessionSweeper(std::chrono::milliseconds interval, int batchSize);
+
+	// Starts the background thread and sweeps once right away.
+	void start();
+	void stop();
+	// One full sweep on the calling thread; also what the background task runs.
+	void sweep();
+	SessionSweepStats stats() const;
+
+private:
+	const int batchSize;
+	std::atomic<uint64_t> runs{0};
+	std::atomic<uint64_t> rowsRemoved{0};
+	std::atomic<uint64_t> lastRunRowsRemoved{0};
+	std::atomic<uint64_t> lastBatchMicros{0};
+	std::atomic<uint64_t> maxBatchMicros{0};
+	PeriodicTask task;
+};
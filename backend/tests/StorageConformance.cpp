@@ -0,0 +1,231 @@
+// Runs the same checks against one Storage engine, named on the command line:
+//   storage_conformance sqlite <db path>
+//   storage_conformance memory
+// Both engines must pass unchanged; CMake registers one test per engine.
+#include <cstdio>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+#include "../database/Database.h"
+#include "../database/MemoryStorage.h"
+
+namespace {
+	int failures = 0;
+
+	void check(bool ok, const char* what, int line) {
+		if (!ok) {
+			std::printf("FAIL line %d: %s\n", line, what);
+			++failures;
+		}
+	}
+
+#define CHECK(cond) check((cond), #cond, __LINE__)
+
+	std::vector<int> idsOf(const std::vector<Order>& orders) {
+		std::vector<int> ids;
+		for (const auto& o : orders) {
+			ids.push_back(o.id);
+		}
+		return ids;
+	}
+
+	void checkDishes(Storage& s) {
+		std::string err;
+		const auto all = s.getAllDishes(err);
+		CHECK(all.size() == 10);
+		CHECK(!all.empty() && all.front().id == 1 && all.front().name == "Margherita Pizza" && all.back().id == 10);
+
+		const auto created = s.createDish({0, "New", "d", "Cat", 4.0, true}, err);
+		CHECK(created == std::optional<int>(11));
+		CHECK(s.updateDish(11, std::nullopt, std::nullopt, std::nullopt, 4.5, false, err));
+		const auto updated = s.getDish(11, err);
+		CHECK(updated.has_value() && updated->price == 4.5 && !updated->isAvailable && updated->name == "New");
+		CHECK(s.updateDish(999, std::string("x"), std::nullopt, std::nullopt, std::nullopt, std::nullopt, err));
+		CHECK(!s.getDish(999, err).has_value());
+
+		const auto upserted = s.upsertDishes({{0, "U1", "", "C", 1.0, true}, {2, "Caesar 2", "", "Salad", 6.5, true}, {50, "Fifty", "", "C", 2.0, true}}, err);
+		CHECK(upserted == std::optional<int>(3));
+		const auto replaced = s.getDish(2, err);
+		CHECK(replaced.has_value() && replaced->name == "Caesar 2" && replaced->price == 6.5);
+		const auto page = s.getDishesPage(9, 3, err);
+		CHECK(page.size() == 3 && page[0].id == 10 && page[1].id == 11 && page[2].id == 12 && page[2].name == "U1");
+		const auto tail = s.getDishesPage(12, 10, err);
+		CHECK(tail.size() == 1 && tail[0].id == 50);
+		CHECK(err.empty());
+	}
+
+	void checkAccounts(Storage& s) {
+		std::string err;
+		CHECK(s.createUser("alice001", "h", "123", err));
+		CHECK(!s.createUser("alice001", "h", "123", err));
+		CHECK(!err.empty());
+		err.clear();
+		CHECK(s.createMerchant("shop", "h", "Store", err));
+		CHECK(!s.createMerchant("shop", "h", "Store", err));
+		err.clear();
+
+		const auto user = s.getUserByUsername("alice001", err);
+		CHECK(user.has_value() && user->id == 1 && user->phone == "123");
+		const auto merchant = s.getMerchantByUsername("shop", err);
+		CHECK(merchant.has_value() && merchant->id == 1 && merchant->storeName == "Store");
+		CHECK(s.getUserById(1, err).has_value());
+		CHECK(s.getMerchantById(1, err).has_value());
+		CHECK(!s.getUserByUsername("nobody", err).has_value());
+		CHECK(!s.getUserById(42, err).has_value());
+		CHECK(err.empty());
+	}
+
+	void checkSessions(Storage& s) {
+		std::string err;
+		const EpochMillis now = nowEpochMillis();
+		CHECK(s.createSessionToken("live", 1, std::nullopt, now + 100000, err));
+		CHECK(s.createSessionToken("old1", std::nullopt, 1, now - 1, err));
+		CHECK(s.createSessionToken("old2", 1, std::nullopt, now - 5, err));
+		CHECK(!s.createSessionToken("live", 1, std::nullopt, now, err));
+		err.clear();
+
+		const auto live = s.getSessionByToken("live", err);
+		CHECK(live.has_value() && live->userId == std::optional<int>(1) && !live->merchantId.has_value());
+		CHECK(!s.getSessionByToken("old1", err).has_value());
+		CHECK(s.deleteExpiredSessions(1, err) == std::optional<int>(1));
+		CHECK(s.deleteExpiredSessions(10, err) == std::optional<int>(1));
+		CHECK(s.deleteExpiredSessions(10, err) == std::optional<int>(0));
+		CHECK(s.getSessionByToken("live", err).has_value());
+		CHECK(err.empty());
+	}
+
+	void checkOrders(Storage& s) {
+		std::string err;
+		CHECK(!s.createOrder({}, std::nullopt, err).has_value());
+		CHECK(err == "Order items cannot be empty");
+		err.clear();
+		CHECK(!s.createOrder({{11, 1, 0}}, std::nullopt, err).has_value());
+		CHECK(err == "Dish not available");
+		err.clear();
+		CHECK(!s.createOrder({{1, 1, 0}}, 12345, err).has_value());
+		err.clear();
+
+		// Orders 1..7; the odd ones belong to user 1. Prices come from the menu.
+		for (int i = 0; i < 7; ++i) {
+			const auto id = s.createOrder({{1 + i % 3, 1 + i, 0}, {4, 1, 0}}, i % 2 ? std::optional<int>(1) : std::nullopt, err);
+			CHECK(id == std::optional<int>(i + 1));
+		}
+		const auto first = s.getOrder(1, err);
+		CHECK(first.has_value() && first->status == "pending" && first->total == 16.0 && first->items.size() == 2);
+		CHECK(first.has_value() && first->items[0].unitPrice == 8.5 && !first->userId.has_value());
+		CHECK(!s.getOrder(4242, err).has_value());
+
+		CHECK(s.updateOrderStatus(1, "completed", err));
+		CHECK(s.updateOrderStatus(2, "completed", err));
+		CHECK(s.markOrderPickupNotified(2, err));
+		CHECK(s.updateOrderStatus(3, "ready", err));
+		CHECK(s.updateOrderStatus(9999, "ready", err));
+		const auto batch = s.updateOrderStatuses({{4, "preparing"}, {9999, "ready"}, {5, "completed"}}, err);
+		CHECK(batch.has_value() && batch->size() == 3);
+		if (batch.has_value() && batch->size() == 3) {
+			CHECK((*batch)[0].has_value() && (*batch)[0]->status == "preparing");
+			CHECK(!(*batch)[1].has_value());
+			CHECK((*batch)[2].has_value() && (*batch)[2]->status == "completed");
+		}
+		CHECK(s.updateOrderStatus(1, "ready", err));
+		const auto second = s.getOrder(2, err);
+		CHECK(second.has_value() && second->status == "completed" && second->pickupNotified && second->userId == std::optional<int>(1));
+
+		CHECK(idsOf(s.getAllOrders(err)) == std::vector<int>({7, 6, 5, 4, 3, 2, 1}));
+		CHECK(idsOf(s.getOrdersByUser(1, err)) == std::vector<int>({6, 4, 2}));
+		CHECK(idsOf(s.getActiveOrders(err)) == std::vector<int>({7, 6, 5, 4, 3, 1}));
+		CHECK(idsOf(s.getAllOrdersPage(6, 2, err)) == std::vector<int>({5, 4}));
+		CHECK(idsOf(s.getAllOrdersPage(std::nullopt, 3, err)) == std::vector<int>({7, 6, 5}));
+		CHECK(idsOf(s.getOrdersByUserPage(1, std::nullopt, 2, err)) == std::vector<int>({6, 4}));
+		CHECK(idsOf(s.getOrdersByUserPage(1, 4, 2, err)) == std::vector<int>({2}));
+		CHECK(s.getOrdersByUser(2, err).empty());
+		CHECK(err.empty());
+	}
+
+	// Walks more orders than the memory engine has stripes, one page at a time.
+	void checkPaging(Storage& s) {
+		std::string err;
+		for (int i = 0; i < 40; ++i) {
+			CHECK(s.createOrder({{9, 1, 0}}, i % 3 ? std::nullopt : std::optional<int>(1), err).has_value());
+		}
+		const auto all = idsOf(s.getAllOrders(err));
+		std::vector<int> walked;
+		std::optional<int> cursor;
+		for (;;) {
+			const auto page = s.getAllOrdersPage(cursor, 7, err);
+			if (page.empty()) break;
+			CHECK(page.size() <= 7);
+			for (const auto& o : page) walked.push_back(o.id);
+			cursor = page.back().id;
+		}
+		CHECK(walked == all);
+		CHECK(all.size() == 47 && all.front() == 47 && all.back() == 1);
+
+		const auto mine = idsOf(s.getOrdersByUser(1, err));
+		walked.clear();
+		cursor.reset();
+		for (;;) {
+			const auto page = s.getOrdersByUserPage(1, cursor, 5, err);
+			if (page.empty()) break;
+			for (const auto& o : page) walked.push_back(o.id);
+			cursor = page.back().id;
+		}
+		CHECK(walked == mine);
+		CHECK(mine.size() == 17);
+		CHECK(err.empty());
+	}
+
+	void checkSalesReport(Storage& s) {
+		std::string err;
+		const EpochDay today = epochDayOf(nowEpochMillis());
+		const auto report = s.getSalesReport(today - 1, today, err);
+		CHECK(report.days.size() == 1);
+		if (report.days.size() == 1) {
+			const auto& day = report.days[0];
+			CHECK(day.day == today && day.orderCount == 47 && day.revenue == 405.5);
+			CHECK(day.completedCount == 2 && day.completedRevenue == 60.5);
+		}
+		CHECK(report.dishes.size() == 5);
+		if (report.dishes.size() == 5) {
+			CHECK(report.dishes[0].dishId == 9 && report.dishes[0].quantity == 40 && report.dishes[0].revenue == 120.0);
+			CHECK(report.dishes[1].dishId == 1 && report.dishes[1].name == "Margherita Pizza" && report.dishes[1].quantity == 12);
+			CHECK(report.dishes[4].dishId == 2 && report.dishes[4].name == "Caesar 2" && report.dishes[4].revenue == 45.5);
+		}
+		CHECK(s.getSalesReport(today - 10, today - 5, err).days.empty());
+		CHECK(err.empty());
+	}
+}
+
+int main(int argc, char** argv) {
+	const std::string engine = argc > 1 ? argv[1] : "";
+	std::unique_ptr<MemoryStorage> memoryStorage;
+	if (engine == "memory") {
+		memoryStorage = std::make_unique<MemoryStorage>();
+		Storage::use(*memoryStorage);
+	} else if (engine == "sqlite" && argc > 2) {
+		const std::string path = argv[2];
+		for (const char* suffix : {"", "-wal", "-shm"}) {
+			std::error_code ec;
+			std::filesystem::remove(path + suffix, ec);
+		}
+		std::string err;
+		if (!Database::instance().open(path, err, 2)) {
+			std::printf("cannot open %s: %s\n", path.c_str(), err.c_str());
+			return 1;
+		}
+	} else {
+		std::printf("usage: %s memory | sqlite <db path>\n", argv[0]);
+		return 2;
+	}
+
+	Storage& storage = Storage::instance();
+	checkDishes(storage);
+	checkAccounts(storage);
+	checkSessions(storage);
+	checkOrders(storage);
+	checkPaging(storage);
+	checkSalesReport(storage);
+	std::printf("%s: %d failure(s)\n", engine.c_str(), failures);
+	return failures == 0 ? 0 : 1;
+}
@@ -22,8 +22,9 @@ CREATE TABLE IF NOT EXISTS sessions (
 	token TEXT NOT NULL UNIQUE,
 	user_id INTEGER,
 	merchant_id INTEGER,
-	expires_at TEXT NOT NULL,
-	created_at TEXT NOT NULL DEFAULT CURRENT_TIMESTAMP,
+	-- epoch milliseconds (UTC), written by the backend
+	expires_at INTEGER NOT NULL DEFAULT 0,
+	created_at INTEGER NOT NULL DEFAULT 0,
 	FOREIGN KEY(user_id) REFERENCES users(id) ON DELETE CASCADE,
 	FOREIGN KEY(merchant_id) REFERENCES merchants(id) ON DELETE CASCADE
 );
@@ -45,8 +46,9 @@ CREATE TABLE IF NOT EXISTS orders (
 	status TEXT NOT NULL DEFAULT 'pending',
 	total REAL NOT NULL DEFAULT 0,
 	pickup_notified INTEGER NOT NULL DEFAULT 0,
-	created_at TEXT NOT NULL DEFAULT CURRENT_TIMESTAMP,
-	updated_at TEXT NOT NULL DEFAULT CURRENT_TIMESTAMP,
+	-- epoch milliseconds (UTC), written by the backend
+	created_at INTEGER NOT NULL DEFAULT 0,
+	updated_at INTEGER NOT NULL DEFAULT 0,
 	FOREIGN KEY(user_id) REFERENCES users(id) ON DELETE SET NULL
 );
 
@@ -60,4 +62,36 @@ CREATE TABLE IF NOT EXISTS order_items (
 	FOREIGN KEY(dish_id) REFERENCES dishes(id)
 );
 
+-- Sales aggregates per UTC day (epoch milliseconds / 86400000) of order
+-- creation, maintained by the backend in the order write transactions.
+CREATE TABLE IF NOT EXISTS daily_sales (
+	day INTEGER PRIMARY KEY,
+	order_count INTEGER NOT NULL DEFAULT 0,
+	revenue REAL NOT NULL DEFAULT 0,
+	completed_count INTEGER NOT NULL DEFAULT 0,
+	completed_revenue REAL NOT NULL DEFAULT 0
+);
+
+CREATE TABLE IF NOT EXISTS dish_sales (
+	day INTEGER NOT NULL,
+	dish_id INTEGER NOT NULL,
+	quantity INTEGER NOT NULL DEFAULT 0,
+	revenue REAL NOT NULL DEFAULT 0,
+	PRIMARY KEY(day, dish_id)
+) WITHOUT ROWID;
+
+-- Highest order event lsn applied to the tables above (ORDER_EVENT_LOG_DIR).
+CREATE TABLE IF NOT EXISTS event_log_state (
+	id INTEGER PRIMARY KEY CHECK (id = 1),
+	applied_lsn INTEGER NOT NULL
+);
+INSERT OR IGNORE INTO event_log_state(id, applied_lsn) VALUES (1, 0);
+
+CREATE INDEX IF NOT EXISTS idx_order_items_order_id ON order_items(order_id);
+CREATE INDEX IF NOT EXISTS idx_orders_user_id ON orders(user_id, id DESC);
+CREATE INDEX IF NOT EXISTS idx_orders_status_id ON orders(status, id);
+CREATE INDEX IF NOT EXISTS idx_sessions_expires_at ON sessions(expires_at);
 
+-- Must match the latest migration in backend/database/Migrations.cpp so the
+-- backend treats a database created from this file as up to date.
+PRAGMA user_version = 5;
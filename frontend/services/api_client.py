@@ -21,10 +21,25 @@ def _request(method: str, path: str, token: str | None = None, **kwargs):
 		return resp.text
 
 
+# 最近一次菜单响应: (后端地址, ETag, 菜单列表)。菜单未变时后端返回 304，直接复用。
+_menu_cache = None
+
+
 def fetch_menu():
-	result = _request("GET", "/menu") or []
+	global _menu_cache
+	base = get_backend_base()
+	headers = {}
+	if _menu_cache and _menu_cache[0] == base:
+		headers["If-None-Match"] = _menu_cache[1]
+	resp = requests.get(f"{base}/menu", headers=headers, timeout=5)
+	if resp.status_code == 304 and headers:
+		return _menu_cache[2]
+	resp.raise_for_status()
+	result = resp.json() if resp.content else []
 	if not isinstance(result, list):
 		raise ValueError(f"菜单API返回的不是列表: {type(result)}")
+	etag = resp.headers.get("ETag")
+	_menu_cache = (base, etag, result) if etag else None
 	return result
 
 
@@ -0,0 +1,59 @@
+"""Measure POST /orders throughput against a running backend.
+
+Run it once per configuration and compare, e.g.
+
+	restaurant_backend                                     # per-order commits
+	ORDER_GROUP_COMMIT_MAX_BATCH=32 restaurant_backend     # group commit
+
+	python scripts/bench_order_create.py --threads 16 --seconds 10
+"""
+import argparse
+import threading
+import time
+
+import requests
+
+
+def login(base_url: str, username: str, password: str) -> str:
+	requests.post(f"{base_url}/auth/user/register", json={"username": username, "password": password}, timeout=5)
+	resp = requests.post(f"{base_url}/auth/user/login", json={"username": username, "password": password}, timeout=5)
+	resp.raise_for_status()
+	return resp.json()["token"]
+
+
+def main() -> None:
+	parser = argparse.ArgumentParser()
+	parser.add_argument("--url", default="http://127.0.0.1:8081")
+	parser.add_argument("--threads", type=int, default=16)
+	parser.add_argument("--seconds", type=float, default=10.0)
+	parser.add_argument("--username", default="bench001")
+	args = parser.parse_args()
+
+	token = login(args.url, args.username, "bench-password")
+	headers = {"Authorization": f"Bearer {token}"}
+	body = {"items": [{"dishId": 1, "quantity": 1}, {"dishId": 2, "quantity": 2}]}
+	created = [0] * args.threads
+	failed = [0] * args.threads
+	deadline = time.perf_counter() + args.seconds
+
+	def worker(slot: int) -> None:
+		session = requests.Session()
+		while time.perf_counter() < deadline:
+			resp = session.post(f"{args.url}/orders", json=body, headers=headers, timeout=10)
+			if resp.status_code == 201:
+				created[slot] += 1
+			else:
+				failed[slot] += 1
+
+	start = time.perf_counter()
+	threads = [threading.Thread(target=worker, args=(i,)) for i in range(args.threads)]
+	for t in threads:
+		t.start()
+	for t in threads:
+		t.join()
+	elapsed = time.perf_counter() - start
+	print(f"threads={args.threads} created={sum(created)} failed={sum(failed)} orders/sec={sum(created) / elapsed:.0f}")
+
+
+if __name__ == "__main__":
+	main()
@@ -0,0 +1,91 @@
+"""Compare per-order item lookups (N+1) with the single ordered JOIN used by
+Database::getAllOrders. Builds a throwaway database per size. Both sides get
+an index on order_items(order_id); without it the N+1 path scans the whole
+items table per order and the larger sizes never finish.
+
+	python scripts/bench_order_listing.py            # 10k, 100k, 1M orders
+	python scripts/bench_order_listing.py 5000 20000
+"""
+import random
+import sqlite3
+import sys
+import tempfile
+import time
+from pathlib import Path
+
+ROOT = Path(__file__).resolve().parents[1]
+SCHEMA = ROOT / "db" / "schema.sql"
+
+HEADER_SQL = "SELECT id, status, total, user_id, pickup_notified, created_at, updated_at FROM orders ORDER BY id DESC"
+ITEMS_SQL = "SELECT dish_id, quantity, unit_price FROM order_items WHERE order_id = ? ORDER BY id"
+JOIN_SQL = (
+	"SELECT o.id, o.status, o.total, o.user_id, o.pickup_notified, o.created_at, o.updated_at, "
+	"i.dish_id, i.quantity, i.unit_price "
+	"FROM orders o LEFT JOIN order_items i ON i.order_id = o.id "
+	"ORDER BY o.id DESC, i.id"
+)
+
+
+def seed(conn: sqlite3.Connection, orders: int) -> None:
+	conn.executescript(SCHEMA.read_text(encoding="utf-8"))
+	conn.executemany(
+		"INSERT INTO dishes(id, name, price) VALUES(?, ?, ?)",
+		[(i, f"dish {i}", 5.0 + i) for i in range(1, 11)],
+	)
+	rng = random.Random(42)
+	conn.executemany(
+		"INSERT INTO orders(id, status, total) VALUES(?, 'completed', 0)",
+		((i,) for i in range(1, orders + 1)),
+	)
+	conn.executemany(
+		"INSERT INTO order_items(order_id, dish_id, quantity, unit_price) VALUES(?, ?, ?, ?)",
+		(
+			(order_id, rng.randint(1, 10), rng.randint(1, 3), 6.0)
+			for order_id in range(1, orders + 1)
+			for _ in range(rng.randint(1, 4))
+		),
+	)
+	conn.execute("CREATE INDEX IF NOT EXISTS bench_order_items_order ON order_items(order_id)")
+	conn.commit()
+
+
+def n_plus_one(conn: sqlite3.Connection) -> int:
+	rows = 0
+	for header in conn.execute(HEADER_SQL).fetchall():
+		rows += len(conn.execute(ITEMS_SQL, (header[0],)).fetchall())
+	return rows
+
+
+def single_join(conn: sqlite3.Connection) -> int:
+	rows = 0
+	last_id = None
+	for row in conn.execute(JOIN_SQL):
+		if row[0] != last_id:
+			last_id = row[0]
+		if row[7] is not None:
+			rows += 1
+	return rows
+
+
+def timed(fn, conn):
+	start = time.perf_counter()
+	rows = fn(conn)
+	return time.perf_counter() - start, rows
+
+
+def main() -> None:
+	sizes = [int(arg) for arg in sys.argv[1:]] or [10_000, 100_000, 1_000_000]
+	print(f"{'orders':>10} {'n+1 (s)':>10} {'join (s)':>10} {'speedup':>8}")
+	for size in sizes:
+		with tempfile.TemporaryDirectory() as tmp:
+			conn = sqlite3.connect(str(Path(tmp) / "bench.db"))
+			seed(conn, size)
+			slow, slow_rows = timed(n_plus_one, conn)
+			fast, fast_rows = timed(single_join, conn)
+			conn.close()
+		assert slow_rows == fast_rows, (slow_rows, fast_rows)
+		print(f"{size:>10} {slow:>10.3f} {fast:>10.3f} {slow / fast:>7.1f}x")
+
+
+if __name__ == "__main__":
+	main()